@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ActivationRegion.hpp"
+#include "GameObject.hpp"
+
+/*
+    Does the bounding box of obj overlap the region (l, t, r, b) ?
+*/
+bool CActivationRegion::IsInside(LPGAMEOBJECT obj, float l, float t, float r, float b) {
+    float left, top, right, bottom;
+    obj->GetCachedBoundingBox(left, top, right, bottom);
+    return !(right < l || left > r || bottom < t || top > b);
+}
+
+void CActivationRegion::Sleep(LPGAMEOBJECT obj) {
+    float l, t, r, b;
+    obj->GetCachedBoundingBox(l, t, r, b);
+    maxWidth = max(maxWidth, r - l);
+
+    columns[GetColumn(l)].push_back(obj);
+}
+
+/*
+    Remove every sleeping object overlapping the region (l, t, r, b) and append it to woken
+*/
+void CActivationRegion::Wake(float l, float t, float r, float b, vector<LPGAMEOBJECT> &woken) {
+    int first = GetColumn(l - maxWidth);
+    int last = GetColumn(r);
+
+    for (int c = first; c <= last; c++) {
+        auto it = columns.find(c);
+        if (it == columns.end())
+            continue;
+
+        vector<LPGAMEOBJECT> &column = it->second;
+        for (size_t i = 0; i < column.size();) {
+            if (IsInside(column[i], l, t, r, b)) {
+                woken.push_back(column[i]);
+                column[i] = column.back();
+                column.pop_back();
+            } else
+                i++;
+        }
+    }
+}
+
+void CActivationRegion::Remove(LPGAMEOBJECT obj) {
+    float l, t, r, b;
+    obj->GetCachedBoundingBox(l, t, r, b);
+    Remove(obj, l);
+}
+
+void CActivationRegion::Remove(LPGAMEOBJECT obj, float left) {
+    auto it = columns.find(GetColumn(left));
+    if (it == columns.end())
+        return;
+
+    vector<LPGAMEOBJECT> &column = it->second;
+    column.erase(std::remove(column.begin(), column.end(), obj), column.end());
+}
+
+void CActivationRegion::Clear() {
+    columns.clear();
+    maxWidth = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+class CGameObject;
+typedef CGameObject *LPGAMEOBJECT;
+
+#define ACTIVATION_COLUMN_WIDTH 256.0f
+
+// Objects within this distance (in pixels) of the camera view are awake
+#define ACTIVATION_MARGIN 64.0f
+
+// Awake objects only fall asleep this much further away, so that objects right on the edge
+// of the region do not flip between awake and asleep every frame
+#define ACTIVATION_HYSTERESIS 32.0f
+
+/*
+    Sleeping objects of a scene, bucketed by fixed-width columns along X
+
+    Sleeping objects do not move, so their column never changes while asleep. Waking the objects
+    near the camera only visits the columns around it, whatever the length of the level.
+*/
+class CActivationRegion {
+    unordered_map<int, vector<LPGAMEOBJECT>> columns;
+    float maxWidth; // widest box ever put to sleep, bounds how far left Wake has to look
+
+    static int GetColumn(float x) { return (int)floor(x / ACTIVATION_COLUMN_WIDTH); }
+
+public:
+    CActivationRegion() { maxWidth = 0; }
+
+    void Sleep(LPGAMEOBJECT obj);
+    void Wake(float l, float t, float r, float b, vector<LPGAMEOBJECT> &woken);
+    void Remove(LPGAMEOBJECT obj);
+
+    // Same, for an object put to sleep when its box started at left and that has moved since
+    void Remove(LPGAMEOBJECT obj, float left);
+    void Clear();
+
+    static bool IsInside(LPGAMEOBJECT obj, float l, float t, float r, float b);
+};
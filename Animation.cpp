@@ -14,6 +14,11 @@ void CAnimation::Add(int spriteId, DWORD time) {
     frames.push_back(frame);
 }
 
+CAnimation::~CAnimation() {
+    for (size_t i = 0; i < frames.size(); i++)
+        delete frames[i];
+}
+
 void CAnimation::Render(float x, float y) {
     ULONGLONG now = GetTickCount64();
     if (currentFrame == -1) {
@@ -6,6 +6,7 @@
 #include <windows.h>
 
 #include "AnimationFrame.hpp"
+#include "SceneArena.hpp"
 #include "Sprites.hpp"
 
 class CAnimation {
@@ -15,11 +16,16 @@ class CAnimation {
     std::vector<LPANIMATION_FRAME> frames;
 
 public:
+    // Animations and their frames are loaded with the scene and live in its arena, see CSceneArena
+    static void *operator new(size_t size) { return CSceneArena::New(size); }
+    static void operator delete(void *p, size_t size) { CSceneArena::Delete(p, size); }
+
     CAnimation(int defaultTime = 100) {
         this->defaultTime = defaultTime;
         lastFrameTime = -1;
         currentFrame = -1;
     }
+    ~CAnimation();
     void Add(int spriteId, DWORD time = 0);
     void Render(float x, float y);
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "SceneArena.hpp"
 #include "Sprite.hpp"
 
 /*
@@ -10,6 +11,9 @@ class CAnimationFrame {
     DWORD time;
 
 public:
+    static void *operator new(size_t size) { return CSceneArena::New(size); }
+    static void operator delete(void *p, size_t size) { CSceneArena::Delete(p, size); }
+
     CAnimationFrame(LPSPRITE sprite, int time) {
         this->sprite = sprite;
         this->time = time;
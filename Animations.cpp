@@ -2,8 +2,11 @@
 #include "debug.hpp"
 
 CAnimations *CAnimations::__instance = NULL;
+thread_local CAnimations *CAnimations::loading = NULL;
 
 CAnimations *CAnimations::GetInstance() {
+    if (loading != NULL)
+        return loading;
     if (__instance == NULL)
         __instance = new CAnimations();
     return __instance;
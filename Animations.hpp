@@ -5,6 +5,7 @@
 
 class CAnimations {
     static CAnimations *__instance;
+    static thread_local CAnimations *loading; // see SetLoading
 
     unordered_map<int, LPANIMATION> animations;
 
@@ -13,5 +14,12 @@ public:
     LPANIMATION Get(int id);
     void Clear();
 
+    // Exchange the contents with staging, see CScenePrefetcher
+    void Swap(CAnimations *staging) { animations.swap(staging->animations); }
+
+    // Make GetInstance return staging on this thread, so that a scene loading in the background
+    // fills its own animations instead of the ones in use. NULL goes back to the shared instance
+    static void SetLoading(CAnimations *staging) { loading = staging; }
+
     static CAnimations *GetInstance();
 };
@@ -9,6 +9,7 @@
 #define ID_TEX_ENEMY 10
 #define ID_TEX_MISC 20
 
+#define OBJECT_TYPE_UNKNOWN -1
 #define OBJECT_TYPE_MARIO 0
 #define OBJECT_TYPE_BRICK 1
 #define OBJECT_TYPE_GOOMBA 2
@@ -18,6 +19,38 @@
 
 #define OBJECT_TYPE_PORTAL 50
 
+// Object types must stay below this value, it sizes the collision dispatch table
+#define MAX_OBJECT_TYPE 64
+
+// Collision layers, one bit each. A moving object only tests the objects whose layer is in its
+// mask, other pairs are rejected before any swept test (see CCollision::Scan)
+#define COLLISION_LAYER_NONE 0
+#define COLLISION_LAYER_PLAYER (1 << 0)
+#define COLLISION_LAYER_TERRAIN (1 << 1) // bricks, platforms
+#define COLLISION_LAYER_ENEMY (1 << 2)
+#define COLLISION_LAYER_ITEM (1 << 3)    // coins
+#define COLLISION_LAYER_TRIGGER (1 << 4) // portals
+#define COLLISION_LAYER_ALL 0xFFFFFFFF
+
+#define COLLISION_LAYER_MARIO COLLISION_LAYER_PLAYER
+#define COLLISION_MASK_MARIO (COLLISION_LAYER_TERRAIN | COLLISION_LAYER_ENEMY | COLLISION_LAYER_ITEM | COLLISION_LAYER_TRIGGER)
+
+// Goombas walk through each other and ignore coins and portals
+#define COLLISION_LAYER_GOOMBA COLLISION_LAYER_ENEMY
+#define COLLISION_MASK_GOOMBA (COLLISION_LAYER_TERRAIN | COLLISION_LAYER_PLAYER)
+
+#define COLLISION_LAYER_BRICK COLLISION_LAYER_TERRAIN
+#define COLLISION_MASK_BRICK COLLISION_LAYER_NONE
+
+#define COLLISION_LAYER_PLATFORM COLLISION_LAYER_TERRAIN
+#define COLLISION_MASK_PLATFORM COLLISION_LAYER_NONE
+
+#define COLLISION_LAYER_COIN COLLISION_LAYER_ITEM
+#define COLLISION_MASK_COIN COLLISION_LAYER_NONE
+
+#define COLLISION_LAYER_PORTAL COLLISION_LAYER_TRIGGER
+#define COLLISION_MASK_PORTAL COLLISION_LAYER_NONE
+
 #pragma region MARIO
 
 #define ID_SPRITE_MARIO 10000
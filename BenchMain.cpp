@@ -0,0 +1,55 @@
+#include <cstring>
+
+#include "CollisionBench.hpp"
+#include "Utils.hpp"
+#include "debug.hpp"
+
+/*
+    The collision_bench tool of the CMake build: runs the CCollisionBench suites and prints the
+    results. Exits with 1 when a bench failed
+
+    collision_bench [suite ...]: the named suites only, among collision, entity, dispatch,
+    savestate, rewind and batch. All of them without any
+*/
+static bool IsSuiteAsked(int argc, char *argv[], const char *suite) {
+    if (argc < 2)
+        return true;
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], suite) == 0)
+            return true;
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    SetDebugConsole(true);
+
+    const char *suites[] = {"collision", "entity", "dispatch", "savestate", "rewind", "batch"};
+    for (int i = 1; i < argc; i++) {
+        bool isKnown = false;
+        for (int j = 0; j < 6; j++)
+            isKnown = isKnown || strcmp(argv[i], suites[j]) == 0;
+        if (!isKnown) {
+            DebugOut(L"[ERROR] Unknown suite %s. Usage: collision_bench [collision] [entity] [dispatch] [savestate] [rewind] [batch]\n",
+                     ToWSTR(argv[i]).c_str());
+            return 2;
+        }
+    }
+
+    bool isPassed = true;
+    if (IsSuiteAsked(argc, argv, "collision"))
+        CCollisionBench::RunSuite();
+    if (IsSuiteAsked(argc, argv, "entity"))
+        CCollisionBench::RunEntityBench();
+    if (IsSuiteAsked(argc, argv, "dispatch"))
+        isPassed = CCollisionBench::RunDispatchBench() && isPassed;
+    if (IsSuiteAsked(argc, argv, "savestate"))
+        isPassed = CCollisionBench::RunSaveStateBench() && isPassed;
+    if (IsSuiteAsked(argc, argv, "rewind"))
+        isPassed = CCollisionBench::RunRewindBench() && isPassed;
+    if (IsSuiteAsked(argc, argv, "batch"))
+        isPassed = CCollisionBench::RunSceneBatchBench() && isPassed;
+
+    if (!isPassed)
+        DebugOut(L"[ERROR] A bench failed\n");
+    return isPassed ? 0 : 1;
+}
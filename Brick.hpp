@@ -2,6 +2,7 @@
 
 #include "Animation.hpp"
 #include "Animations.hpp"
+#include "AssetIDs.hpp"
 #include "GameObject.hpp"
 
 #define ID_ANI_BRICK 10000
@@ -11,8 +12,12 @@
 
 class CBrick : public CGameObject {
 public:
-    CBrick(float x, float y) : CGameObject(x, y) {}
+    CBrick(float x, float y) : CGameObject(x, y) {
+        type = OBJECT_TYPE_BRICK;
+        SetCollisionLayer(COLLISION_LAYER_BRICK, COLLISION_MASK_BRICK);
+    }
     void Render();
     void Update(DWORD dt) {}
     void GetBoundingBox(float &l, float &t, float &r, float &b);
+    int IsStatic() { return 1; }
 };
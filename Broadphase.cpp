@@ -0,0 +1,25 @@
+#include "Broadphase.hpp"
+#include "GameObject.hpp"
+
+void CBroadphase::GetSweptBox(LPGAMEOBJECT obj, DWORD dt, float &l, float &t, float &r, float &b) {
+    obj->GetCachedBoundingBox(l, t, r, b);
+
+    float vx, vy;
+    obj->GetSpeed(vx, vy);
+    float dx = vx * dt;
+    float dy = vy * dt;
+
+    if (dx > 0)
+        r += dx;
+    else
+        l += dx;
+    if (dy > 0)
+        b += dy;
+    else
+        t += dy;
+
+    l -= BROADPHASE_PADDING;
+    t -= BROADPHASE_PADDING;
+    r += BROADPHASE_PADDING;
+    b += BROADPHASE_PADDING;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+class CGameObject;
+typedef CGameObject *LPGAMEOBJECT;
+
+// Extra room (in pixels) around every tracked box, so small position changes made outside of
+// an object's own Update (e.g. a Goomba being stomped) never move it out of its cells/interval
+#define BROADPHASE_PADDING 8.0f
+
+/*
+    Abstract collision broadphase
+
+    Objects are tracked by their swept bounding box (current box + movement over dt).
+    Query returns each tracked object whose box may overlap the queried box exactly once, in an
+    order that only depends on the inserts and removes made so far, so that collision results
+    are the same whenever the same objects went in and out in the same order
+
+    The const Query only works in the scratch buffer it is given, so several threads may query
+    at the same time as long as nobody inserts, updates or removes objects meanwhile
+*/
+class CBroadphase {
+    vector<int> found;
+
+public:
+    virtual void Insert(LPGAMEOBJECT obj, DWORD dt = 0) = 0;
+    virtual void Update(LPGAMEOBJECT obj, DWORD dt) = 0;
+    virtual void Remove(LPGAMEOBJECT obj) = 0;
+    virtual void Clear() = 0;
+
+    virtual void Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result, vector<int> &found) const = 0;
+    void Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result) { Query(l, t, r, b, result, found); }
+
+    virtual size_t GetSize() = 0;
+
+    // Swept bounding box of obj over dt, padded by BROADPHASE_PADDING
+    static void GetSweptBox(LPGAMEOBJECT obj, DWORD dt, float &l, float &t, float &r, float &b);
+
+    virtual ~CBroadphase() {}
+};
+
+typedef CBroadphase *LPBROADPHASE;
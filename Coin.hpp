@@ -2,6 +2,7 @@
 
 #include "Animation.hpp"
 #include "Animations.hpp"
+#include "AssetIDs.hpp"
 #include "GameObject.hpp"
 
 #define ID_ANI_COIN 11000
@@ -12,7 +13,10 @@
 
 class CCoin : public CGameObject {
 public:
-    CCoin(float x, float y) : CGameObject(x, y) {}
+    CCoin(float x, float y) : CGameObject(x, y) {
+        type = OBJECT_TYPE_COIN;
+        SetCollisionLayer(COLLISION_LAYER_COIN, COLLISION_MASK_COIN);
+    }
     void Render();
     void Update(DWORD dt) {}
     void GetBoundingBox(float &l, float &t, float &r, float &b);
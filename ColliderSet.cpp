@@ -0,0 +1,30 @@
+#include "ColliderSet.hpp"
+
+void CColliderSet::Add(LPGAMEOBJECT obj) {
+    if (ids.find(obj) != ids.end())
+        return;
+
+    ids[obj] = (int)objects.size();
+    objects.push_back(obj);
+}
+
+void CColliderSet::Remove(LPGAMEOBJECT obj) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    int id = it->second;
+    ids.erase(it);
+
+    LPGAMEOBJECT last = objects.back();
+    objects.pop_back();
+    if (last != obj) {
+        objects[id] = last;
+        ids[last] = id;
+    }
+}
+
+void CColliderSet::Clear() {
+    objects.clear();
+    ids.clear();
+}
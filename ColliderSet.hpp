@@ -0,0 +1,33 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class CGameObject;
+typedef CGameObject *LPGAMEOBJECT;
+
+/*
+    Set of objects other objects collide with, kept up to date as objects come and go instead of
+    being rebuilt every frame
+
+    Add and Remove are O(1): removing swaps the last object into the freed place. GetObjects gives
+    the dense list that is handed to Update and CCollision as coObjects, it only changes when the
+    owner adds or removes objects
+*/
+class CColliderSet {
+    vector<LPGAMEOBJECT> objects;
+    unordered_map<LPGAMEOBJECT, int> ids; // object -> index in objects
+
+public:
+    void Add(LPGAMEOBJECT obj);
+    void Remove(LPGAMEOBJECT obj);
+    bool Contains(LPGAMEOBJECT obj) { return ids.find(obj) != ids.end(); }
+    void Clear();
+
+    vector<LPGAMEOBJECT> *GetObjects() { return &objects; }
+    size_t GetSize() { return objects.size(); }
+};
+
+typedef CColliderSet *LPCOLLIDERSET;
@@ -1,11 +1,15 @@
 #include "Collision.hpp"
 #include "GameObject.hpp"
+#include "StaticLayer.hpp"
 
 #include "debug.hpp"
 
 #define BLOCK_PUSH_FACTOR 0.4f
 
-CCollision *CCollision::__instance = NULL;
+// An object resting on its ground is pushed BLOCK_PUSH_FACTOR above it, allow a bit more than that
+#define GROUND_CONTACT_TOLERANCE 1.0f
+
+thread_local CCollision *CCollision::__instance = NULL;
 
 CCollision *CCollision::GetInstance() {
     if (__instance == NULL)
@@ -98,10 +102,47 @@ void CCollision::SweptAABB(
     }
 }
 
+/*
+    Is objSrc, about to move at (vx, vy), still standing on the object it last landed on?
+
+    True while it is not moving up, the ground does not move and is still under objSrc after its
+    move on X, and objSrc rests right on top of it
+*/
+bool CCollision::IsOnGround(LPGAMEOBJECT objSrc, DWORD dt, float vx, float vy) const {
+    LPGAMEOBJECT ground = objSrc->GetGround();
+    if (ground == NULL || vy < 0)
+        return false;
+    if (ground->IsDeleted() || !ground->IsBlocking())
+        return false;
+
+    float gvx, gvy;
+    ground->GetSpeed(gvx, gvy);
+    if (gvx != 0 || gvy != 0)
+        return false;
+
+    float ml, mt, mr, mb;
+    float gl, gt, gr, gb;
+    objSrc->GetCachedBoundingBox(ml, mt, mr, mb);
+    ground->GetCachedBoundingBox(gl, gt, gr, gb);
+
+    float dx = vx * dt;
+    if (ml + dx >= gr || mr + dx <= gl)
+        return false; // walked off
+
+    float gap = gt - mb;
+    return gap >= 0 && gap <= GROUND_CONTACT_TOLERANCE;
+}
+
 /*
     Extension of original SweptAABB to deal with two moving objects
 */
 LPCOLLISIONEVENT CCollision::SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJECT objDest) {
+    CCollisionEvent e(-1.0f, 0, 0);
+    SweptAABB(objSrc, dt, objDest, e);
+    return NewEvent(e);
+}
+
+void CCollision::SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJECT objDest, CCollisionEvent &e) {
     float sl, st, sr, sb; // static object bbox
     float ml, mt, mr, mb; // moving object bbox
     float t, nx, ny;
@@ -122,8 +163,8 @@ LPCOLLISIONEVENT CCollision::SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJE
     float dx = mdx - sdx;
     float dy = mdy - sdy;
 
-    objSrc->GetBoundingBox(ml, mt, mr, mb);
-    objDest->GetBoundingBox(sl, st, sr, sb);
+    objSrc->GetCachedBoundingBox(ml, mt, mr, mb);
+    objDest->GetCachedBoundingBox(sl, st, sr, sb);
 
     SweptAABB(
         ml, mt, mr, mb,
@@ -131,8 +172,7 @@ LPCOLLISIONEVENT CCollision::SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJE
         sl, st, sr, sb,
         t, nx, ny);
 
-    CCollisionEvent *e = new CCollisionEvent(t, nx, ny, dx, dy, objDest, objSrc);
-    return e;
+    e = CCollisionEvent(t, nx, ny, dx, dy, objDest, objSrc);
 }
 
 /*
@@ -140,15 +180,89 @@ LPCOLLISIONEVENT CCollision::SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJE
 
     coObjects: the list of colliable objects
     coEvents: list of potential collisions
+
+    NOTE: when a broadphase is attached, the candidates are taken from it instead of objDests.
+    The broadphase is expected to hold the same objects as objDests (see CPlayScene::Update)
+
+    When a static layer is attached, static objects are tested through its tiles and skipped here.
+    Their events come first, before those of the moving objects: as Filter keeps the first of the
+    events with the smallest t, a static object hit at the same time as a moving one wins,
+    wherever they are in coObjects (without the layer, the first of them in coObjects wins)
 */
 void CCollision::Scan(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *objDests, vector<LPCOLLISIONEVENT> &coEvents) {
+    float vx, vy;
+    objSrc->GetSpeed(vx, vy);
+
+    scratch.events.clear();
+    Scan(objSrc, dt, vx, vy, objDests, scratch, scratch.events);
+
+    for (size_t i = 0; i < scratch.events.size(); i++)
+        coEvents.push_back(NewEvent(scratch.events[i]));
+}
+
+void CCollision::Scan(LPGAMEOBJECT objSrc, DWORD dt, float mvx, float mvy,
+                      vector<LPGAMEOBJECT> *objDests,
+                      CCollisionScratch &scratch,
+                      vector<CCollisionEvent> &coEvents) const {
+    float ml, mt, mr, mb;
+    objSrc->GetCachedBoundingBox(ml, mt, mr, mb);
+
+    float mdx = mvx * dt;
+    float mdy = mvy * dt;
+
+    UINT mask = objSrc->GetCollisionMask();
+
+    if (staticLayer != NULL)
+        staticLayer->Scan(objSrc, ml, mt, mr, mb, mdx, mdy, scratch, coEvents);
+
+    if (broadphase != NULL) {
+        // swept box of the mover, candidates are bucketed by their own swept box
+        scratch.candidates.clear();
+        broadphase->Query(
+            mdx < 0 ? ml + mdx : ml,
+            mdy < 0 ? mt + mdy : mt,
+            mdx > 0 ? mr + mdx : mr,
+            mdy > 0 ? mb + mdy : mb,
+            scratch.candidates,
+            scratch.found);
+        objDests = &scratch.candidates;
+    }
+
+    // gather the targets into structure of arrays, then sweep all of them in one batch
+    CSweptAABBBatch &scanBatch = scratch.batch;
+    scanBatch.Clear();
     for (UINT i = 0; i < objDests->size(); i++) {
-        LPCOLLISIONEVENT e = SweptAABB(objSrc, dt, objDests->at(i));
+        LPGAMEOBJECT obj = objDests->at(i);
+        if (obj == objSrc)
+            continue;
+        if (staticLayer != NULL && obj->IsStatic())
+            continue;
+        if ((obj->GetCollisionLayer() & mask) == 0) {
+            scratch.pairsRejected++;
+            continue;
+        }
 
-        if (e->WasCollided() == 1)
-            coEvents.push_back(e);
-        else
-            delete e;
+        float sl, st, sr, sb;
+        obj->GetCachedBoundingBox(sl, st, sr, sb);
+
+        float svx, svy;
+        obj->GetSpeed(svx, svy);
+
+        scanBatch.Add(obj, sl, st, sr, sb, svx * dt, svy * dt);
+    }
+
+    scanBatch.Run(ml, mt, mr, mb, mdx, mdy);
+    scratch.pairsTested += scanBatch.Size();
+
+    for (size_t i = 0; i < scanBatch.Size(); i++) {
+        if (scanBatch.t[i] < 0.0f || scanBatch.t[i] > 1.0f)
+            continue;
+
+        // NOTE: event movement is relative to the target, see SweptAABB
+        coEvents.push_back(CCollisionEvent(
+            scanBatch.t[i], scanBatch.nx[i], scanBatch.ny[i],
+            mdx - scanBatch.sdx[i], mdy - scanBatch.sdy[i],
+            scanBatch.obj[i], objSrc));
     }
 
     // std::sort(coEvents.begin(), coEvents.end(), CCollisionEvent::compare);
@@ -203,16 +317,29 @@ void CCollision::Filter(LPGAMEOBJECT objSrc,
  *  NOTE: Student might need to improve this based on game logic
  */
 void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *coObjects) {
-    vector<LPCOLLISIONEVENT> coEvents;
+    vector<LPCOLLISIONEVENT> &coEvents = processEvents;
     LPCOLLISIONEVENT colX = NULL;
     LPCOLLISIONEVENT colY = NULL;
+    LPGAMEOBJECT landedOn = NULL;
 
+    size_t eventMark = events.GetMark();
     coEvents.clear();
 
+    // Still standing on last frame's ground: it stops the fall, so there is no need to sweep
+    // down into it again. Only horizontal movement and other objects are scanned for
+    LPGAMEOBJECT ground = NULL;
     if (objSrc->IsCollidable()) {
-        Scan(objSrc, dt, coObjects, coEvents);
+        float vx, vy;
+        objSrc->GetSpeed(vx, vy);
+        if (IsOnGround(objSrc, dt, vx, vy)) {
+            ground = objSrc->GetGround();
+            objSrc->SetSpeed(vx, 0);
+        }
     }
 
+    if (objSrc->IsCollidable())
+        Scan(objSrc, dt, coObjects, coEvents);
+
     // No collision detected
     if (coEvents.size() == 0) {
         objSrc->OnNoCollision(dt);
@@ -231,6 +358,8 @@ void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *co
                 y += colY->t * dy + colY->ny * BLOCK_PUSH_FACTOR;
                 objSrc->SetPosition(x, y);
 
+                if (colY->ny < 0)
+                    landedOn = colY->obj;
                 objSrc->OnCollisionWith(colY);
 
                 //
@@ -280,6 +409,8 @@ void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *co
 
                 if (colY_other != NULL) {
                     y += colY_other->t * dy + colY_other->ny * BLOCK_PUSH_FACTOR;
+                    if (colY_other->ny < 0)
+                        landedOn = colY_other->obj;
                     objSrc->OnCollisionWith(colY_other);
                 } else {
                     y += dy;
@@ -292,6 +423,8 @@ void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *co
         } else if (colY != NULL) {
             x += dx;
             y += colY->t * dy + colY->ny * BLOCK_PUSH_FACTOR;
+            if (colY->ny < 0)
+                landedOn = colY->obj;
             objSrc->OnCollisionWith(colY);
         } else // both colX & colY are NULL
         {
@@ -302,6 +435,14 @@ void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *co
         objSrc->SetPosition(x, y);
     }
 
+    // the ground still reports the contact, as the floor event of a full sweep would
+    if (landedOn != NULL)
+        objSrc->SetGround(landedOn);
+    else if (ground != NULL)
+        objSrc->OnCollisionWith(NewEvent(CCollisionEvent(0.0f, 0, -1.0f, 0, 0, ground, objSrc)));
+    else
+        objSrc->SetGround(NULL);
+
     //
     // Scan all non-blocking collisions for further collision logic
     //
@@ -315,6 +456,7 @@ void CCollision::Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *co
         objSrc->OnCollisionWith(e);
     }
 
-    for (UINT i = 0; i < coEvents.size(); i++)
-        delete coEvents[i];
+    // release all events of this pass at once
+    coEvents.clear();
+    events.Rewind(eventMark);
 }
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <algorithm>
+#include <new>
 #include <vector>
 #include <windows.h>
 
+#include "Broadphase.hpp"
+
+class CStaticLayer;
+typedef CStaticLayer *LPSTATICLAYER;
+
 using namespace std;
 
 class CGameObject;
@@ -40,10 +46,131 @@ struct CCollisionEvent {
     }
 };
 
+// Kernels of CCollision::SweptAABBBatch
+#define SWEPT_AABB_KERNEL_SCALAR 0
+#define SWEPT_AABB_KERNEL_SSE 1
+#define SWEPT_AABB_KERNEL_AVX 2
+
+/*
+    Targets of a batched SweptAABB, stored as structure of arrays so that several targets can be
+    tested with one SIMD instruction. Results are written back into t, nx, ny
+*/
+struct CSweptAABBBatch {
+    vector<LPGAMEOBJECT> obj;
+    vector<float> sl, st, sr, sb; // target bounding boxes
+    vector<float> sdx, sdy;       // target movement during dt
+
+    vector<float> t, nx, ny;
+
+    void Clear() {
+        obj.clear();
+        sl.clear();
+        st.clear();
+        sr.clear();
+        sb.clear();
+        sdx.clear();
+        sdy.clear();
+    }
+
+    void Add(LPGAMEOBJECT o, float l, float t, float r, float b, float dx = 0, float dy = 0) {
+        obj.push_back(o);
+        sl.push_back(l);
+        st.push_back(t);
+        sr.push_back(r);
+        sb.push_back(b);
+        sdx.push_back(dx);
+        sdy.push_back(dy);
+    }
+
+    size_t Size() { return obj.size(); }
+
+    void Run(float ml, float mt, float mr, float mb, float mdx, float mdy);
+};
+
+/*
+    Working buffers of one collision scan. Each thread scanning concurrently needs its own
+*/
+struct CCollisionScratch {
+    vector<LPGAMEOBJECT> candidates;
+    vector<int> found;
+    CSweptAABBBatch batch;
+    vector<CCollisionEvent> events;
+
+    size_t pairsTested;   // pairs that went through the swept test
+    size_t pairsRejected; // pairs skipped because of collision layers
+
+    CCollisionScratch() { pairsTested = pairsRejected = 0; }
+};
+
+#define COLLISION_EVENT_BLOCK_SIZE 256
+
+/*
+    Bump allocator for collision events
+
+    Events are copied into fixed-size blocks that are never given back to the heap, so once the
+    arena has grown to the busiest frame, allocating events costs no heap allocation at all.
+    Rewind() releases every event allocated after a mark in one go.
+*/
+class CCollisionEventArena {
+    vector<LPCOLLISIONEVENT> blocks;
+    size_t used;
+    size_t allocations; // number of heap allocations made by the arena so far
+
+public:
+    CCollisionEventArena() {
+        used = 0;
+        allocations = 0;
+    }
+
+    LPCOLLISIONEVENT New(const CCollisionEvent &e) {
+        size_t block = used / COLLISION_EVENT_BLOCK_SIZE;
+        if (block == blocks.size()) {
+            blocks.push_back((LPCOLLISIONEVENT)::operator new(sizeof(CCollisionEvent) * COLLISION_EVENT_BLOCK_SIZE));
+            allocations++;
+        }
+
+        LPCOLLISIONEVENT p = blocks[block] + used % COLLISION_EVENT_BLOCK_SIZE;
+        used++;
+        return new (p) CCollisionEvent(e);
+    }
+
+    size_t GetMark() { return used; }
+    void Rewind(size_t mark) { used = mark; }
+    size_t GetAllocationCount() { return allocations; }
+
+    ~CCollisionEventArena() {
+        for (size_t i = 0; i < blocks.size(); i++)
+            ::operator delete(blocks[i]);
+    }
+};
+
+/*
+    Sweeps movers against their candidates and dispatches the collision events
+
+    One instance per thread (see GetInstance): what is set for a frame (broadphase, static layer)
+    and the events belong to the scene being updated on that thread, so that several
+    scenes can be updated at once (see CPlaySceneBatch)
+*/
 class CCollision {
-    static CCollision *__instance;
+    static thread_local CCollision *__instance;
+
+    LPBROADPHASE broadphase; // when set, Scan only tests the candidates it returns for the mover
+
+    LPSTATICLAYER staticLayer; // when set, static objects are swept through the layer's tiles instead
+
+    CCollisionEventArena events;
+    vector<LPCOLLISIONEVENT> processEvents; // reused by Process to avoid a new vector per call
+
+    CCollisionScratch scratch; // used by Scan on the calling thread, also holds the pair counters
+
+    void SweptAABB(LPGAMEOBJECT objSrc, DWORD dt, LPGAMEOBJECT objDest, CCollisionEvent &e);
 
 public:
+    CCollision() {
+        broadphase = NULL;
+        staticLayer = NULL;
+    }
+
     static void SweptAABB(
         float ml, // move left
         float mt, // move top
@@ -59,6 +186,33 @@ public:
         float &nx,
         float &ny);
 
+    //
+    // Same as SweptAABB above for one moving object against count targets, each moving by (sdx, sdy).
+    // Uses SSE or AVX when available (picked at runtime), results are identical to the scalar version
+    //
+    static void SweptAABBBatch(
+        float ml, float mt, float mr, float mb,
+        float mdx, float mdy,
+        const float *sl, const float *st, const float *sr, const float *sb,
+        const float *sdx, const float *sdy,
+        size_t count,
+        float *t, float *nx, float *ny);
+
+    // SweptAABBBatch with the given kernel (SWEPT_AABB_KERNEL_xxx) rather than the one picked at
+    // runtime, so that each can be checked against SweptAABB. False when the build or the CPU does
+    // not have it
+    static bool SweptAABBBatchWith(
+        int kernel,
+        float ml, float mt, float mr, float mb,
+        float mdx, float mdy,
+        const float *sl, const float *st, const float *sr, const float *sb,
+        const float *sdx, const float *sdy,
+        size_t count,
+        float *t, float *nx, float *ny);
+
+    static const wchar_t *GetBatchKernelName();
+
+    // The returned event lives in the event arena, see NewEvent
     LPCOLLISIONEVENT SweptAABB(
         LPGAMEOBJECT objSrc,
         DWORD dt,
@@ -69,6 +223,16 @@ public:
         vector<LPGAMEOBJECT> *objDests,
         vector<LPCOLLISIONEVENT> &coEvents);
 
+    // Same as Scan with objSrc moving at (vx, vy), but events are returned by value and only the
+    // given scratch is written to: safe to call from several threads while no object changes
+    void Scan(
+        LPGAMEOBJECT objSrc,
+        DWORD dt,
+        float vx, float vy,
+        vector<LPGAMEOBJECT> *objDests,
+        CCollisionScratch &scratch,
+        vector<CCollisionEvent> &coEvents) const;
+
     void Filter(
         LPGAMEOBJECT objSrc,
         vector<LPCOLLISIONEVENT> &coEvents,
@@ -80,5 +244,32 @@ public:
 
     void Process(LPGAMEOBJECT objSrc, DWORD dt, vector<LPGAMEOBJECT> *coObjects);
 
+    // Whether Process will keep objSrc on its ground instead of sweeping it down (see CGameObject::GetGround)
+    bool IsOnGround(LPGAMEOBJECT objSrc, DWORD dt, float vx, float vy) const;
+
+    void SetBroadphase(LPBROADPHASE broadphase) { this->broadphase = broadphase; }
+    LPBROADPHASE GetBroadphase() { return broadphase; }
+
+    // Events are owned by the arena: never delete them. They stay valid until the end of the
+    // Process call that created them, or until ResetEvents when created outside of Process
+    LPCOLLISIONEVENT NewEvent(const CCollisionEvent &e) { return events.New(e); }
+    void ResetEvents() { events.Rewind(0); }
+    size_t GetEventAllocationCount() { return events.GetAllocationCount(); }
+
+    // Pairs swept vs pairs rejected by collision layers since the last ResetPairStats
+    void GetPairStats(size_t &tested, size_t &rejected) {
+        tested = scratch.pairsTested;
+        rejected = scratch.pairsRejected;
+    }
+    void AddPairStats(size_t tested, size_t rejected) {
+        scratch.pairsTested += tested;
+        scratch.pairsRejected += rejected;
+    }
+    void ResetPairStats() { scratch.pairsTested = scratch.pairsRejected = 0; }
+
+    void SetStaticLayer(LPSTATICLAYER layer) { staticLayer = layer; }
+    LPSTATICLAYER GetStaticLayer() { return staticLayer; }
+
+
     static CCollision *GetInstance();
 };
@@ -0,0 +1,626 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "Brick.hpp"
+#include "Collision.hpp"
+#include "CollisionBench.hpp"
+#include "CollisionDispatch.hpp"
+#include "EntityStore.hpp"
+#include "Goomba.hpp"
+#include "PlayScene.hpp"
+#include "PlaySceneBatch.hpp"
+#include "SpatialGrid.hpp"
+#include "StaticLayer.hpp"
+#include "SweepAndPrune.hpp"
+#include "Utils.hpp"
+#include "debug.hpp"
+
+#define COLLISION_BENCH_FLOOR_Y 400.0f
+#define COLLISION_BENCH_SWEPT_REPEAT 200
+
+// Skip brute force worlds above this many pairs per frame, they would take minutes
+#define COLLISION_BENCH_MAX_BRUTE_PAIRS 2000000.0
+
+typedef std::chrono::steady_clock CBenchClock;
+
+static double ElapsedNs(CBenchClock::time_point start) {
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(CBenchClock::now() - start).count();
+}
+
+static float RandomFloat(float a, float b) {
+    return a + (b - a) * (rand() / (float)RAND_MAX);
+}
+
+/*
+    Time the swept test alone on random box pairs, scalar and batched
+*/
+void CCollisionBench::TimeSweptAABB(unsigned int seed, CCollisionBenchResult &result) {
+    srand(seed);
+
+    size_t n = COLLISION_BENCH_SWEPT_PAIRS;
+    vector<float> ml(n), mt(n), dx(n), dy(n);
+    vector<float> sl(n), st(n), sr(n), sb(n), sdx(n, 0), sdy(n, 0);
+    vector<float> t(n), nx(n), ny(n);
+
+    for (size_t i = 0; i < n; i++) {
+        ml[i] = RandomFloat(0, 64);
+        mt[i] = RandomFloat(0, 64);
+        dx[i] = RandomFloat(-16, 16);
+        dy[i] = RandomFloat(-16, 16);
+        sl[i] = RandomFloat(0, 64);
+        st[i] = RandomFloat(0, 64);
+        sr[i] = sl[i] + 16;
+        sb[i] = st[i] + 16;
+    }
+
+    float sink = 0;
+
+    CBenchClock::time_point start = CBenchClock::now();
+    for (int k = 0; k < COLLISION_BENCH_SWEPT_REPEAT; k++)
+        for (size_t i = 0; i < n; i++) {
+            float ht, hnx, hny;
+            CCollision::SweptAABB(ml[i], mt[i], ml[i] + 16, mt[i] + 16, dx[i], dy[i],
+                                  sl[i], st[i], sr[i], sb[i], ht, hnx, hny);
+            sink += ht;
+        }
+    result.sweptNsPerPair = ElapsedNs(start) / (n * COLLISION_BENCH_SWEPT_REPEAT);
+
+    // the batch sweeps one mover against all targets, as Scan does
+    start = CBenchClock::now();
+    for (int k = 0; k < COLLISION_BENCH_SWEPT_REPEAT; k++) {
+        size_t i = k % n;
+        CCollision::SweptAABBBatch(ml[i], mt[i], ml[i] + 16, mt[i] + 16, dx[i], dy[i],
+                                   &sl[0], &st[0], &sr[0], &sb[0], &sdx[0], &sdy[0], n,
+                                   &t[0], &nx[0], &ny[0]);
+        sink += t[i];
+    }
+    result.batchNsPerPair = ElapsedNs(start) / (n * COLLISION_BENCH_SWEPT_REPEAT);
+
+    for (int kernel = SWEPT_AABB_KERNEL_SCALAR; kernel <= SWEPT_AABB_KERNEL_AVX; kernel++) {
+        result.kernelNsPerPair[kernel] = 0;
+        start = CBenchClock::now();
+        for (int k = 0; k < COLLISION_BENCH_SWEPT_REPEAT; k++) {
+            size_t i = k % n;
+            if (!CCollision::SweptAABBBatchWith(kernel, ml[i], mt[i], ml[i] + 16, mt[i] + 16, dx[i], dy[i],
+                                                &sl[0], &st[0], &sr[0], &sb[0], &sdx[0], &sdy[0], n,
+                                                &t[0], &nx[0], &ny[0]))
+                break;
+            sink += t[i];
+            if (k == COLLISION_BENCH_SWEPT_REPEAT - 1)
+                result.kernelNsPerPair[kernel] = ElapsedNs(start) / (n * COLLISION_BENCH_SWEPT_REPEAT);
+        }
+    }
+
+    if (sink == 12345.0f) // keeps the compiler from dropping the loops
+        DebugOut(L"");
+}
+
+void CCollisionBench::Run(const CCollisionBenchConfig &config, CCollisionBenchResult &result) {
+    TimeSweptAABB(config.seed, result);
+
+    srand(config.seed);
+
+    vector<LPGAMEOBJECT> objects;
+    int columns = max(1, (int)(config.worldWidth / 16));
+
+    for (int i = 0; i < config.bricks; i++) {
+        if (i < columns)
+            objects.push_back(new CBrick(i * 16.0f, COLLISION_BENCH_FLOOR_Y));
+        else
+            objects.push_back(new CBrick((rand() % columns) * 16.0f, COLLISION_BENCH_FLOOR_Y - 16.0f * (1 + rand() % 8)));
+    }
+
+    for (int i = 0; i < config.goombas; i++) {
+        LPGAMEOBJECT goomba = new CGoomba(RandomFloat(16, config.worldWidth - 32), RandomFloat(COLLISION_BENCH_FLOOR_Y - 300, COLLISION_BENCH_FLOOR_Y - 150));
+        float vx = GOOMBA_WALKING_SPEED * config.speedScale;
+        goomba->SetSpeed(rand() % 2 ? vx : -vx, 0);
+        objects.push_back(goomba);
+    }
+
+    LPBROADPHASE broadphase = NULL;
+    if (config.broadphase == COLLISION_BENCH_SPATIAL_GRID)
+        broadphase = new CSpatialGrid();
+    else if (config.broadphase == COLLISION_BENCH_SWEEP_AND_PRUNE)
+        broadphase = new CSweepAndPrune();
+
+    CStaticLayer staticLayer;
+    if (broadphase != NULL) {
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (objects[i]->IsStatic())
+                staticLayer.Add(objects[i]);
+            else
+                broadphase->Insert(objects[i]);
+        }
+        staticLayer.Build();
+    }
+
+    CCollision *collision = CCollision::GetInstance();
+    collision->SetBroadphase(broadphase);
+    collision->SetStaticLayer(broadphase != NULL ? &staticLayer : NULL);
+
+    DWORD dt = COLLISION_BENCH_STEP;
+    double scanNs = 0, filterNs = 0, processNs = 0;
+    double scanPairs = 0, pairs = 0, events = 0;
+    vector<double> frames;
+    vector<LPCOLLISIONEVENT> coEvents;
+
+    for (int f = 0; f < config.frames; f++) {
+        // measurement pass: Scan and Filter alone, on the world as it is before the frame
+        collision->ResetPairStats();
+        for (size_t i = 0; i < objects.size(); i++) {
+            LPGAMEOBJECT obj = objects[i];
+            if (obj->IsStatic())
+                continue;
+
+            coEvents.clear();
+            CBenchClock::time_point start = CBenchClock::now();
+            collision->Scan(obj, dt, &objects, coEvents);
+            scanNs += ElapsedNs(start);
+            events += coEvents.size();
+
+            LPCOLLISIONEVENT colX, colY;
+            start = CBenchClock::now();
+            collision->Filter(obj, coEvents, colX, colY, 1, 1, 1);
+            filterNs += ElapsedNs(start);
+
+            collision->ResetEvents();
+        }
+
+        size_t tested, rejected;
+        collision->GetPairStats(tested, rejected);
+        scanPairs += tested;
+
+        // the frame itself, the same steps as CPlayScene::Update
+        collision->ResetPairStats();
+        CBenchClock::time_point frameStart = CBenchClock::now();
+
+        if (broadphase != NULL)
+            for (size_t i = 0; i < objects.size(); i++)
+                if (!objects[i]->IsStatic())
+                    broadphase->Update(objects[i], dt);
+
+        CBenchClock::time_point updateStart = CBenchClock::now();
+        for (size_t i = 0; i < objects.size(); i++) {
+            objects[i]->Update(dt, &objects);
+            if (broadphase != NULL && !objects[i]->IsStatic())
+                broadphase->Update(objects[i], dt);
+        }
+        processNs += ElapsedNs(updateStart);
+        frames.push_back(ElapsedNs(frameStart));
+
+        collision->ResetEvents();
+        collision->GetPairStats(tested, rejected);
+        pairs += tested;
+    }
+
+    collision->SetBroadphase(NULL);
+    collision->SetStaticLayer(NULL);
+
+    for (size_t i = 0; i < objects.size(); i++)
+        delete objects[i];
+    delete broadphase;
+
+    int n = max(1, config.frames);
+    result.scanNsPerFrame = scanNs / n;
+    result.filterNsPerFrame = filterNs / n;
+    result.processNsPerFrame = processNs / n;
+    result.scanNsPerPair = scanPairs > 0 ? scanNs / scanPairs : 0;
+    result.pairsPerFrame = pairs / n;
+    result.eventsPerFrame = events / n;
+
+    result.frameP50Ns = result.frameP99Ns = 0;
+    if (!frames.empty()) {
+        sort(frames.begin(), frames.end());
+        result.frameP50Ns = frames[frames.size() / 2];
+        result.frameP99Ns = frames[min(frames.size() - 1, frames.size() * 99 / 100)];
+    }
+}
+
+void CCollisionBench::Report(const CCollisionBenchConfig &config, const CCollisionBenchResult &result) {
+    const wchar_t *names[] = {L"brute force", L"spatial grid", L"sweep and prune"};
+
+    DebugOut(L"[BENCH] %d bricks, %d goombas, width %.0f, speed x%.1f, %s (%s kernel)\n",
+             config.bricks, config.goombas, config.worldWidth, config.speedScale,
+             names[config.broadphase], CCollision::GetBatchKernelName());
+    DebugOut(L"[BENCH]   SweptAABB %.2f ns/pair, batched %.2f ns/pair (scalar %.2f, SSE %.2f, AVX %.2f)\n",
+             result.sweptNsPerPair, result.batchNsPerPair, result.kernelNsPerPair[SWEPT_AABB_KERNEL_SCALAR],
+             result.kernelNsPerPair[SWEPT_AABB_KERNEL_SSE], result.kernelNsPerPair[SWEPT_AABB_KERNEL_AVX]);
+    DebugOut(L"[BENCH]   Scan %.1f us/frame (%.2f ns/pair), Filter %.1f us/frame, Process %.1f us/frame\n",
+             result.scanNsPerFrame / 1000, result.scanNsPerPair, result.filterNsPerFrame / 1000, result.processNsPerFrame / 1000);
+    DebugOut(L"[BENCH]   %.0f pairs/frame, %.1f events/frame, frame p50 %.1f us, p99 %.1f us\n",
+             result.pairsPerFrame, result.eventsPerFrame, result.frameP50Ns / 1000, result.frameP99Ns / 1000);
+}
+
+void CCollisionBench::RunSuite() {
+    const int sizes[][2] = {{500, 50}, {2000, 200}, {8000, 1000}};
+    const float densities[] = {16, 4}; // world width per brick: floor only, or 4 bricks per column
+    const float speeds[] = {1, 4};
+
+    for (int s = 0; s < 3; s++)
+        for (int d = 0; d < 2; d++)
+            for (int v = 0; v < 2; v++)
+                for (int b = COLLISION_BENCH_NO_BROADPHASE; b <= COLLISION_BENCH_SWEEP_AND_PRUNE; b++) {
+                    CCollisionBenchConfig config;
+                    config.bricks = sizes[s][0];
+                    config.goombas = sizes[s][1];
+                    config.worldWidth = sizes[s][0] * densities[d];
+                    config.speedScale = speeds[v];
+                    config.broadphase = b;
+
+                    double brutePairs = (double)config.goombas * (config.bricks + config.goombas);
+                    if (b == COLLISION_BENCH_NO_BROADPHASE && brutePairs > COLLISION_BENCH_MAX_BRUTE_PAIRS)
+                        continue;
+
+                    CCollisionBenchResult result;
+                    Run(config, result);
+                    Report(config, result);
+                }
+}
+
+/*
+    Costs of the CEntityStore prototype on count goombas: its systems on native entities, and the
+    adapter copying objects in and out. Nothing is compared with the objects' own Update, which
+    also scans collisions and animates while Integrate only moves what nothing collides
+*/
+void CCollisionBench::RunEntityBench(int count) {
+    srand(1);
+
+    vector<LPGAMEOBJECT> objects;
+    CEntityStore adapted, native;
+    native.Reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        float x = RandomFloat(0, 100000), y = RandomFloat(0, 1000);
+        LPGAMEOBJECT goomba = new CGoomba(x, y);
+        goomba->SetSpeed(GOOMBA_WALKING_SPEED, 0);
+        objects.push_back(goomba);
+        adapted.AddObject(goomba);
+
+        int id = native.Add(x, y, -GOOMBA_BBOX_WIDTH / 2, -GOOMBA_BBOX_HEIGHT / 2, GOOMBA_BBOX_WIDTH, GOOMBA_BBOX_HEIGHT, OBJECT_TYPE_GOOMBA);
+        native.vx[id] = GOOMBA_WALKING_SPEED;
+        native.ay[id] = GOOMBA_GRAVITY;
+    }
+
+    DWORD dt = COLLISION_BENCH_STEP;
+    vector<int> visible;
+    double gatherNs = 0, scatterNs = 0, integrateNs = 0, boundsNs = 0, cullNs = 0;
+
+    for (int f = 0; f < ENTITY_BENCH_FRAMES; f++) {
+        CBenchClock::time_point start = CBenchClock::now();
+        adapted.Gather();
+        gatherNs += ElapsedNs(start);
+
+        start = CBenchClock::now();
+        adapted.Scatter();
+        scatterNs += ElapsedNs(start);
+
+        start = CBenchClock::now();
+        native.Integrate(dt);
+        integrateNs += ElapsedNs(start);
+
+        start = CBenchClock::now();
+        native.UpdateBounds();
+        boundsNs += ElapsedNs(start);
+
+        start = CBenchClock::now();
+        native.Cull(50000, 0, 50320, 1000, visible);
+        cullNs += ElapsedNs(start);
+    }
+
+    for (size_t i = 0; i < objects.size(); i++)
+        delete objects[i];
+
+    double n = (double)count * ENTITY_BENCH_FRAMES;
+    DebugOut(L"[BENCH] %d entities, %d frames (CEntityStore is a prototype, not used by the game)\n", count,
+             ENTITY_BENCH_FRAMES);
+    DebugOut(L"[BENCH]   entity store: Integrate %.2f ns/entity, UpdateBounds %.2f ns/entity, Cull %.2f ns/entity\n",
+             integrateNs / n, boundsNs / n, cullNs / n);
+    DebugOut(L"[BENCH]   adapter: Gather %.2f ns/entity, Scatter %.2f ns/entity\n", gatherNs / n, scatterNs / n);
+}
+
+/*
+    Objects of the dispatch bench: DISPATCH_BENCH_MAX_TYPES target classes, and sources that count
+    the events they handle by target type
+*/
+template <int N> class CDispatchBenchTarget : public CGameObject {
+public:
+    CDispatchBenchTarget() { type = DISPATCH_BENCH_FIRST_TYPE + N; }
+    void Render() {}
+    void GetBoundingBox(float &l, float &t, float &r, float &b) { l = t = r = b = 0; }
+};
+
+class CDispatchBenchSource : public CGameObject {
+public:
+    int hits[DISPATCH_BENCH_MAX_TYPES];
+
+    CDispatchBenchSource() {
+        type = DISPATCH_BENCH_SOURCE_TYPE;
+        memset(hits, 0, sizeof(hits));
+    }
+    void Render() {}
+    void GetBoundingBox(float &l, float &t, float &r, float &b) { l = t = r = b = 0; }
+};
+
+/*
+    Target types N down to 0: creating them, their handlers, and the dynamic_cast chain that tells
+    them apart, in that order
+*/
+template <int N> struct CDispatchBenchTypes {
+    static LPGAMEOBJECT New(int n) {
+        return n == N ? new CDispatchBenchTarget<N>() : CDispatchBenchTypes<N - 1>::New(n);
+    }
+
+    static void Handle(LPGAMEOBJECT src, LPCOLLISIONEVENT e) {
+        ((CDispatchBenchSource *)src)->hits[N]++;
+    }
+
+    static void Register(CCollisionDispatch *dispatch) {
+        dispatch->Register(DISPATCH_BENCH_SOURCE_TYPE, DISPATCH_BENCH_FIRST_TYPE + N, Handle);
+        CDispatchBenchTypes<N - 1>::Register(dispatch);
+    }
+
+    static void Cast(LPGAMEOBJECT src, LPCOLLISIONEVENT e) {
+        if (dynamic_cast<CDispatchBenchTarget<N> *>(e->obj) != NULL)
+            Handle(src, e);
+        else
+            CDispatchBenchTypes<N - 1>::Cast(src, e);
+    }
+};
+
+template <> struct CDispatchBenchTypes<-1> {
+    static LPGAMEOBJECT New(int n) { return NULL; }
+    static void Register(CCollisionDispatch *dispatch) {}
+    static void Cast(LPGAMEOBJECT src, LPCOLLISIONEVENT e) {}
+};
+
+// As CMario::OnCollisionWith before the dispatch table, with types target types
+template <int types> class CDispatchBenchCastSource : public CDispatchBenchSource {
+public:
+    void OnCollisionWith(LPCOLLISIONEVENT e) { CDispatchBenchTypes<types - 1>::Cast(this, e); }
+};
+
+// As CMario::OnCollisionWith now
+class CDispatchBenchTableSource : public CDispatchBenchSource {
+    CCollisionDispatch *dispatch;
+
+public:
+    CDispatchBenchTableSource(CCollisionDispatch *dispatch) { this->dispatch = dispatch; }
+    void OnCollisionWith(LPCOLLISIONEVENT e) { dispatch->Dispatch(this, e); }
+};
+
+/*
+    Time both sources on the same random events against targets of the first types types
+*/
+template <int types> static bool TimeDispatch(CCollisionDispatch *dispatch) {
+    srand(1);
+
+    vector<LPGAMEOBJECT> targets;
+    for (int i = 0; i < types; i++)
+        targets.push_back(CDispatchBenchTypes<DISPATCH_BENCH_MAX_TYPES - 1>::New(i));
+
+    vector<CCollisionEvent> events;
+    for (int i = 0; i < DISPATCH_BENCH_EVENTS; i++)
+        events.push_back(CCollisionEvent(0.5f, 0, -1.0f, 0, 0, targets[rand() % types]));
+
+    CDispatchBenchTableSource tableSource(dispatch);
+    CDispatchBenchCastSource<types> castSource;
+    LPGAMEOBJECT sources[] = {&tableSource, &castSource};
+    double ns[2];
+
+    for (int s = 0; s < 2; s++) {
+        CBenchClock::time_point start = CBenchClock::now();
+        for (int k = 0; k < DISPATCH_BENCH_REPEAT; k++)
+            for (size_t i = 0; i < events.size(); i++)
+                sources[s]->OnCollisionWith(&events[i]);
+        ns[s] = ElapsedNs(start) / ((double)DISPATCH_BENCH_REPEAT * events.size());
+    }
+
+    bool isSame = memcmp(tableSource.hits, castSource.hits, sizeof(tableSource.hits)) == 0;
+    DebugOut(L"[BENCH]   %d target types: table %.2f ns/event, dynamic_cast chain %.2f ns/event%s\n", types, ns[0],
+             ns[1], isSame ? L"" : L", EVENTS HANDLED DIFFERENTLY");
+
+    for (size_t i = 0; i < targets.size(); i++)
+        delete targets[i];
+    return isSame;
+}
+
+bool CCollisionBench::RunDispatchBench() {
+    CCollisionDispatch dispatch;
+    CDispatchBenchTypes<DISPATCH_BENCH_MAX_TYPES - 1>::Register(&dispatch);
+
+    DebugOut(L"[BENCH] Collision dispatch of %d events, %d times\n", DISPATCH_BENCH_EVENTS, DISPATCH_BENCH_REPEAT);
+    bool isSame = TimeDispatch<2>(&dispatch);
+    isSame = TimeDispatch<4>(&dispatch) && isSame;
+    isSame = TimeDispatch<8>(&dispatch) && isSame;
+    isSame = TimeDispatch<16>(&dispatch) && isSame;
+    isSame = TimeDispatch<DISPATCH_BENCH_MAX_TYPES>(&dispatch) && isSame;
+    return isSame;
+}
+
+/*
+    The scene is loaded from a scene file written on the spot, without assets, so the objects go
+    through the same Load as in the game: a brick floor, goombas walking on it and coins above.
+    The file is a new temporary one, deleted once loaded, so no file of the user is overwritten
+*/
+static WCHAR benchSceneFile[MAX_PATH]; // kept by the scenes loaded from it
+
+static bool WriteBenchScene(int count) {
+    WCHAR tempPath[MAX_PATH];
+    if (GetTempPathW(MAX_PATH, tempPath) == 0 ||
+        GetTempFileNameW(tempPath, SAVE_STATE_BENCH_FILE_PREFIX, 0, benchSceneFile) == 0) {
+        DebugOut(L"[ERROR] Cannot create a temporary file for the bench scene\n");
+        return false;
+    }
+
+    srand(1);
+
+    ofstream f;
+    OpenFile(f, benchSceneFile);
+    f << "[OBJECTS]\n";
+    f << OBJECT_TYPE_MARIO << "\t20\t10\n";
+    for (int i = 1; i < count; i++) {
+        float x = (float)(i / 2) * 16;
+        if (i % 2 == 0)
+            f << OBJECT_TYPE_BRICK << "\t" << x << "\t180\n";
+        else if (i % 4 == 1)
+            f << OBJECT_TYPE_GOOMBA << "\t" << x << "\t" << RandomFloat(100, 160) << "\n";
+        else
+            f << OBJECT_TYPE_COIN << "\t" << x << "\t" << RandomFloat(60, 120) << "\n";
+    }
+    f.close();
+    return true;
+}
+
+static CPlayScene *LoadBenchScene(int count) {
+    if (!WriteBenchScene(count))
+        return NULL;
+
+    CPlayScene *scene = new CPlayScene(-1, benchSceneFile);
+    scene->SetLevelStreaming(false);
+    scene->SetRewindEnabled(false);
+    scene->Load();
+    DeleteFileW(benchSceneFile);
+
+    if (scene->GetPlayer() == NULL) {
+        DebugOut(L"[ERROR] The bench scene did not load\n");
+        scene->Unload();
+        delete scene;
+        return NULL;
+    }
+    return scene;
+}
+
+bool CCollisionBench::RunSaveStateBench(int count) {
+    CPlayScene *scene = LoadBenchScene(count);
+    if (scene == NULL)
+        return false;
+
+    for (int i = 0; i < 10; i++)
+        scene->Update(COLLISION_BENCH_STEP); // goombas fall and land, so grounds get saved too
+
+    vector<BYTE> data;
+    double saveNs = 0, restoreNs = 0, rebuildNs = 0;
+    bool isRestored = true;
+
+    for (int i = 0; i < SAVE_STATE_BENCH_REPEAT; i++) {
+        CBenchClock::time_point start = CBenchClock::now();
+        scene->SaveState(data);
+        saveNs += ElapsedNs(start);
+
+        scene->Update(COLLISION_BENCH_STEP);
+
+        start = CBenchClock::now();
+        isRestored = scene->RestoreState(data) && isRestored;
+        restoreNs += ElapsedNs(start);
+    }
+
+    // without the player the scene no longer holds the objects of the save state: all are created again
+    for (int i = 0; i < SAVE_STATE_BENCH_REPEAT; i++) {
+        scene->GetPlayer()->Delete();
+
+        CBenchClock::time_point start = CBenchClock::now();
+        isRestored = scene->RestoreState(data) && isRestored;
+        rebuildNs += ElapsedNs(start);
+    }
+
+    scene->Unload();
+    delete scene;
+
+    DebugOut(L"[BENCH] Save state of %d objects: %d bytes (%.1f per object)%s\n", count, (int)data.size(),
+             (double)data.size() / count, isRestored ? L"" : L", RESTORE FAILED");
+    DebugOut(L"[BENCH]   SaveState %.3f ms, RestoreState %.3f ms (%.3f ms creating every object again)\n",
+             saveNs / SAVE_STATE_BENCH_REPEAT / 1e6, restoreNs / SAVE_STATE_BENCH_REPEAT / 1e6,
+             rebuildNs / SAVE_STATE_BENCH_REPEAT / 1e6);
+    return isRestored;
+}
+
+/*
+    Mario runs right through the bench scene with rewind on, then the whole buffer is rewound
+*/
+bool CCollisionBench::RunRewindBench(int count) {
+    CPlayScene *scene = LoadBenchScene(count);
+    if (scene == NULL)
+        return false;
+
+    scene->SetRewindEnabled(true);
+    scene->SetActivationMargin(REWIND_BENCH_MARGIN); // there is no back buffer to size the window by
+
+    for (int i = 0; i < REWIND_BENCH_FRAMES; i++) {
+        scene->GetPlayer()->SetState(MARIO_STATE_RUNNING_RIGHT);
+        scene->Update(COLLISION_BENCH_STEP);
+    }
+
+    // the frames of the whole rewind window, not whole keyframe intervals fewer
+    LPREWINDBUFFER rewind = scene->GetRewindBuffer();
+    bool isWindowKept = rewind->GetFrameCount() >= (size_t)min(REWIND_BENCH_FRAMES, REWIND_FRAMES);
+    DebugOut(L"[BENCH] Rewind of %d objects, %d frames: %d kept%s, %d KB held\n", count, REWIND_BENCH_FRAMES,
+             (int)rewind->GetFrameCount(), isWindowKept ? L"" : L", FEWER THAN REWIND_FRAMES",
+             (int)(rewind->GetMemory() / 1024));
+    DebugOut(L"[BENCH]   capture %.3f ms average, %.3f ms max, %d of %d over the %.1f ms budget\n",
+             rewind->GetAverageCaptureNs() / 1e6, rewind->GetMaxCaptureNs() / 1e6, (int)rewind->GetOverBudgetCount(),
+             (int)rewind->GetCaptureCount(), REWIND_CAPTURE_BUDGET_NS / 1e6);
+    DebugOut(L"[BENCH]   %.0f bytes per frame: %d keyframes, deltas %.0f bytes\n", rewind->GetAverageFrameBytes(),
+             (int)rewind->GetKeyframeCount(), rewind->GetAverageDeltaBytes());
+
+    int frames = 0;
+    CBenchClock::time_point start = CBenchClock::now();
+    while (rewind->Rewind(scene))
+        frames++;
+    double rewindNs = ElapsedNs(start);
+
+    DebugOut(L"[BENCH]   rewind %.3f ms per frame over %d frames\n", frames > 0 ? rewindNs / frames / 1e6 : 0, frames);
+
+    scene->Unload();
+    delete scene;
+    return frames > 0 && isWindowKept;
+}
+
+/*
+    Random inputs for every scene of a batch, stepped once on the shared worker pool and once on
+    the calling thread alone
+*/
+bool CCollisionBench::RunSceneBatchBench(int scenes, int objects) {
+    if (!WriteBenchScene(objects))
+        return false;
+
+    CWorkerPool single(0);
+    LPWORKERPOOL pools[] = {&single, CWorkerPool::GetInstance()};
+    double stepsPerSecond[2];
+
+    for (int p = 0; p < 2; p++) {
+        CPlaySceneBatch batch(benchSceneFile, scenes, pools[p]);
+        if (batch.GetScene(0)->GetPlayer() == NULL) {
+            DebugOut(L"[ERROR] The bench scenes did not load\n");
+            DeleteFileW(benchSceneFile);
+            return false;
+        }
+        vector<BYTE> inputs(scenes);
+        int episodes = 0;
+
+        srand(1);
+        CBenchClock::time_point start = CBenchClock::now();
+        for (int i = 0; i < SCENE_BATCH_BENCH_STEPS; i++) {
+            for (int j = 0; j < scenes; j++)
+                inputs[j] = (BYTE)(rand() % 32);
+            batch.Step(&inputs[0]);
+
+            const BYTE *dones = batch.GetDones();
+            for (int j = 0; j < scenes; j++)
+                episodes += dones[j];
+        }
+        stepsPerSecond[p] = (double)scenes * SCENE_BATCH_BENCH_STEPS / (ElapsedNs(start) / 1e9);
+
+        DebugOut(L"[BENCH] Batch of %d scenes of %d objects on %d threads: %.0f steps/s, %d episodes done\n",
+                 scenes, objects, pools[p]->GetWorkerCount(), stepsPerSecond[p], episodes);
+    }
+
+    DeleteFileW(benchSceneFile);
+
+    DebugOut(L"[BENCH]   %.2fx on %d threads\n", stepsPerSecond[1] / stepsPerSecond[0],
+             CWorkerPool::GetInstance()->GetWorkerCount());
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+#define COLLISION_BENCH_FRAMES 600
+#define COLLISION_BENCH_STEP 10          // ms per simulated frame, same as the game loop
+#define COLLISION_BENCH_SWEPT_PAIRS 4096 // random box pairs timed through SweptAABB
+
+#define ENTITY_BENCH_COUNT 100000
+#define ENTITY_BENCH_FRAMES 100
+
+#define SAVE_STATE_BENCH_COUNT 10000
+#define SAVE_STATE_BENCH_REPEAT 100
+#define SAVE_STATE_BENCH_FILE_PREFIX L"bsc" // of the temporary scene file, see GetTempFileName
+
+#define REWIND_BENCH_FRAMES 600
+#define REWIND_BENCH_MARGIN 320.0f // activation margin, for about a screen of awake objects
+
+#define DISPATCH_BENCH_EVENTS 100000
+#define DISPATCH_BENCH_REPEAT 20
+#define DISPATCH_BENCH_SOURCE_TYPE 9 // object types of the dispatch bench, unused by the game
+#define DISPATCH_BENCH_FIRST_TYPE 10
+#define DISPATCH_BENCH_MAX_TYPES 32
+
+#define SCENE_BATCH_BENCH_SCENES 64
+#define SCENE_BATCH_BENCH_OBJECTS 1000
+#define SCENE_BATCH_BENCH_STEPS 1000
+
+// Broadphase of a bench world
+#define COLLISION_BENCH_NO_BROADPHASE 0 // every goomba is swept against every object
+#define COLLISION_BENCH_SPATIAL_GRID 1  // static layer + CSpatialGrid, as in CPlayScene
+#define COLLISION_BENCH_SWEEP_AND_PRUNE 2
+
+/*
+    One synthetic world: a brick floor with random brick columns and goombas walking on it
+*/
+struct CCollisionBenchConfig {
+    int bricks;        // N static bricks, the floor takes worldWidth / 16 of them
+    int goombas;       // M moving goombas
+    float worldWidth;  // the smaller the world, the denser it is
+    float speedScale;  // goomba walking speed multiplier
+    int broadphase;    // COLLISION_BENCH_xxx
+    int frames;
+    unsigned int seed;
+
+    CCollisionBenchConfig() {
+        bricks = 1000;
+        goombas = 100;
+        worldWidth = 8000;
+        speedScale = 1;
+        broadphase = COLLISION_BENCH_SPATIAL_GRID;
+        frames = COLLISION_BENCH_FRAMES;
+        seed = 1;
+    }
+};
+
+struct CCollisionBenchResult {
+    double sweptNsPerPair;      // scalar CCollision::SweptAABB
+    double batchNsPerPair;      // CCollision::SweptAABBBatch with the kernel picked at runtime
+    double kernelNsPerPair[3];  // SweptAABBBatchWith each SWEPT_AABB_KERNEL_xxx, 0 when not available
+    double scanNsPerFrame;      // Scan of every goomba
+    double filterNsPerFrame;    // Filter of the scanned events
+    double processNsPerFrame;   // Update (so Process) of every goomba
+    double scanNsPerPair;       // scan time per pair that went through the swept test
+    double pairsPerFrame;       // pairs swept by Process
+    double eventsPerFrame;      // events found by Scan
+    double frameP50Ns, frameP99Ns; // whole frame: broadphase upkeep + update of every object
+};
+
+/*
+    Headless collision benchmark
+
+    Builds synthetic worlds out of the real CBrick and CGoomba classes and times the collision
+    code on them, without any window, device or scene file. Results go to DebugOut, so that
+    broadphase and collision changes can be compared on the same worlds. The collision_bench tool
+    of the CMake build (BenchMain.cpp) runs the standard suites and prints them.
+
+    The benches that go through a scene return false when it did not behave: it did not load,
+    a state did not restore or nothing could be rewound
+*/
+class CCollisionBench {
+    static void TimeSweptAABB(unsigned int seed, CCollisionBenchResult &result);
+
+public:
+    static void Run(const CCollisionBenchConfig &config, CCollisionBenchResult &result);
+    static void Report(const CCollisionBenchConfig &config, const CCollisionBenchResult &result);
+
+    // Sizes x densities x speeds x broadphases
+    static void RunSuite();
+
+    // Cost per entity of the CEntityStore systems and adapter, on count goombas
+    static void RunEntityBench(int count = ENTITY_BENCH_COUNT);
+
+    // The same collision events handled through CCollisionDispatch and through a dynamic_cast
+    // chain in OnCollisionWith, as before it, for 2 to DISPATCH_BENCH_MAX_TYPES target types.
+    // False when both did not handle the same events
+    static bool RunDispatchBench();
+
+    // CPlayScene::SaveState and RestoreState of a scene of count objects
+    static bool RunSaveStateBench(int count = SAVE_STATE_BENCH_COUNT);
+
+    // Per-frame rewind capture of the same scene, while the player runs through it
+    static bool RunRewindBench(int count = SAVE_STATE_BENCH_COUNT);
+
+    // Aggregate steps per second of a CPlaySceneBatch, on one thread and on the worker pool
+    static bool RunSceneBatchBench(int scenes = SCENE_BATCH_BENCH_SCENES, int objects = SCENE_BATCH_BENCH_OBJECTS);
+};
@@ -0,0 +1,45 @@
+#include "CollisionDispatch.hpp"
+#include "GameObject.hpp"
+#include "debug.hpp"
+
+CCollisionDispatch *CCollisionDispatch::__instance = NULL;
+
+CCollisionDispatch *CCollisionDispatch::GetInstance() {
+    if (__instance == NULL)
+        __instance = new CCollisionDispatch();
+    return __instance;
+}
+
+CCollisionDispatch::CCollisionDispatch() {
+    for (int i = 0; i < MAX_OBJECT_TYPE; i++)
+        for (int j = 0; j < MAX_OBJECT_TYPE; j++)
+            handlers[i][j] = NULL;
+}
+
+void CCollisionDispatch::Register(int srcType, int destType, LPCOLLISIONHANDLER handler) {
+    if (srcType < 0 || srcType >= MAX_OBJECT_TYPE || destType < 0 || destType >= MAX_OBJECT_TYPE) {
+        DebugOut(L"[ERROR] Invalid collision handler types: %d, %d\n", srcType, destType);
+        return;
+    }
+
+    handlers[srcType][destType] = handler;
+}
+
+/*
+    Run the handler registered for this pair of types, if any
+    Return 1 if a handler was run
+*/
+int CCollisionDispatch::Dispatch(LPGAMEOBJECT src, LPCOLLISIONEVENT e) {
+    // unsigned compare also rejects OBJECT_TYPE_UNKNOWN
+    unsigned int srcType = (unsigned int)src->GetType();
+    unsigned int destType = (unsigned int)e->obj->GetType();
+    if (srcType >= MAX_OBJECT_TYPE || destType >= MAX_OBJECT_TYPE)
+        return 0;
+
+    LPCOLLISIONHANDLER handler = handlers[srcType][destType];
+    if (handler == NULL)
+        return 0;
+
+    handler(src, e);
+    return 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "AssetIDs.hpp"
+#include "Collision.hpp"
+
+// Type specific collision logic of the source object for one event
+typedef void (*LPCOLLISIONHANDLER)(LPGAMEOBJECT src, LPCOLLISIONEVENT e);
+
+/*
+    Routes collision events to handlers by (source type, target type), see CGameObject::GetType
+
+    Dispatching is a single table lookup, so it costs the same whatever the number of object
+    types, unlike a chain of dynamic_cast
+*/
+class CCollisionDispatch {
+    static CCollisionDispatch *__instance;
+
+    LPCOLLISIONHANDLER handlers[MAX_OBJECT_TYPE][MAX_OBJECT_TYPE];
+
+public:
+    CCollisionDispatch();
+
+    void Register(int srcType, int destType, LPCOLLISIONHANDLER handler);
+    int Dispatch(LPGAMEOBJECT src, LPCOLLISIONEVENT e);
+
+    static CCollisionDispatch *GetInstance();
+};
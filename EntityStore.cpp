@@ -0,0 +1,207 @@
+#include "EntityStore.hpp"
+#include "GameObject.hpp"
+
+int CEntityStore::Add(float x, float y, float boxOffsetX, float boxOffsetY, float boxWidth, float boxHeight,
+                      int type, UINT flags) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    vx.push_back(0);
+    vy.push_back(0);
+    ax.push_back(0);
+    ay.push_back(0);
+    this->boxOffsetX.push_back(boxOffsetX);
+    this->boxOffsetY.push_back(boxOffsetY);
+    this->boxWidth.push_back(boxWidth);
+    this->boxHeight.push_back(boxHeight);
+    l.push_back(x + boxOffsetX);
+    t.push_back(y + boxOffsetY);
+    r.push_back(x + boxOffsetX + boxWidth);
+    b.push_back(y + boxOffsetY + boxHeight);
+    state.push_back(-1);
+    this->type.push_back(type);
+    this->flags.push_back(flags);
+    owner.push_back(NULL);
+
+    return (int)this->x.size() - 1;
+}
+
+int CEntityStore::AddObject(LPGAMEOBJECT obj) {
+    int id = Add(0, 0, 0, 0, 0, 0, obj->GetType(), 0);
+    owner[id] = obj;
+    return id;
+}
+
+void CEntityStore::Remove(int id) {
+    int last = (int)x.size() - 1;
+    if (id != last) {
+        x[id] = x[last];
+        y[id] = y[last];
+        vx[id] = vx[last];
+        vy[id] = vy[last];
+        ax[id] = ax[last];
+        ay[id] = ay[last];
+        boxOffsetX[id] = boxOffsetX[last];
+        boxOffsetY[id] = boxOffsetY[last];
+        boxWidth[id] = boxWidth[last];
+        boxHeight[id] = boxHeight[last];
+        l[id] = l[last];
+        t[id] = t[last];
+        r[id] = r[last];
+        b[id] = b[last];
+        state[id] = state[last];
+        type[id] = type[last];
+        flags[id] = flags[last];
+        owner[id] = owner[last];
+    }
+
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    ax.pop_back();
+    ay.pop_back();
+    boxOffsetX.pop_back();
+    boxOffsetY.pop_back();
+    boxWidth.pop_back();
+    boxHeight.pop_back();
+    l.pop_back();
+    t.pop_back();
+    r.pop_back();
+    b.pop_back();
+    state.pop_back();
+    type.pop_back();
+    flags.pop_back();
+    owner.pop_back();
+}
+
+void CEntityStore::Clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    ax.clear();
+    ay.clear();
+    boxOffsetX.clear();
+    boxOffsetY.clear();
+    boxWidth.clear();
+    boxHeight.clear();
+    l.clear();
+    t.clear();
+    r.clear();
+    b.clear();
+    state.clear();
+    type.clear();
+    flags.clear();
+    owner.clear();
+}
+
+void CEntityStore::Reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    vx.reserve(count);
+    vy.reserve(count);
+    ax.reserve(count);
+    ay.reserve(count);
+    boxOffsetX.reserve(count);
+    boxOffsetY.reserve(count);
+    boxWidth.reserve(count);
+    boxHeight.reserve(count);
+    l.reserve(count);
+    t.reserve(count);
+    r.reserve(count);
+    b.reserve(count);
+    state.reserve(count);
+    type.reserve(count);
+    flags.reserve(count);
+    owner.reserve(count);
+}
+
+/*
+    Copy the state of every owning object into its entity. Objects keep their own acceleration,
+    so ax and ay of owned entities are left untouched
+*/
+void CEntityStore::Gather() {
+    for (size_t i = 0; i < owner.size(); i++) {
+        LPGAMEOBJECT obj = owner[i];
+        if (obj == NULL)
+            continue;
+
+        obj->GetPosition(x[i], y[i]);
+        obj->GetSpeed(vx[i], vy[i]);
+        obj->GetCachedBoundingBox(l[i], t[i], r[i], b[i]);
+        boxOffsetX[i] = l[i] - x[i];
+        boxOffsetY[i] = t[i] - y[i];
+        boxWidth[i] = r[i] - l[i];
+        boxHeight[i] = b[i] - t[i];
+        state[i] = obj->GetState();
+
+        UINT f = 0;
+        if (obj->IsActive())
+            f |= ENTITY_FLAG_ACTIVE;
+        if (obj->IsStatic())
+            f |= ENTITY_FLAG_STATIC;
+        if (obj->IsCollidable())
+            f |= ENTITY_FLAG_COLLIDABLE;
+        if (obj->IsDeleted())
+            f |= ENTITY_FLAG_DELETED;
+        flags[i] = f;
+    }
+}
+
+/*
+    Write position and speed back into the owning objects that systems may have moved
+*/
+void CEntityStore::Scatter() {
+    for (size_t i = 0; i < owner.size(); i++) {
+        LPGAMEOBJECT obj = owner[i];
+        if (obj == NULL || (flags[i] & (ENTITY_FLAG_STATIC | ENTITY_FLAG_DELETED)) != 0)
+            continue;
+
+        obj->SetPosition(x[i], y[i]);
+        obj->SetSpeed(vx[i], vy[i]);
+    }
+}
+
+/*
+    Move active entities that nothing collides: v += a * dt, then p += v * dt
+*/
+void CEntityStore::Integrate(DWORD dt) {
+    float fdt = (float)dt;
+    size_t n = x.size();
+
+    for (size_t i = 0; i < n; i++) {
+        if ((flags[i] & (ENTITY_FLAG_ACTIVE | ENTITY_FLAG_STATIC | ENTITY_FLAG_COLLIDABLE | ENTITY_FLAG_DELETED)) != ENTITY_FLAG_ACTIVE)
+            continue;
+
+        vx[i] += ax[i] * fdt;
+        vy[i] += ay[i] * fdt;
+        x[i] += vx[i] * fdt;
+        y[i] += vy[i] * fdt;
+    }
+}
+
+void CEntityStore::UpdateBounds() {
+    size_t n = x.size();
+
+    for (size_t i = 0; i < n; i++) {
+        l[i] = x[i] + boxOffsetX[i];
+        t[i] = y[i] + boxOffsetY[i];
+        r[i] = l[i] + boxWidth[i];
+        b[i] = t[i] + boxHeight[i];
+    }
+}
+
+/*
+    Render submission: ids of the active entities whose bounding box overlaps the view, in id order
+*/
+void CEntityStore::Cull(float left, float top, float right, float bottom, vector<int> &visible) {
+    visible.clear();
+    size_t n = x.size();
+
+    for (size_t i = 0; i < n; i++) {
+        if ((flags[i] & (ENTITY_FLAG_ACTIVE | ENTITY_FLAG_DELETED)) != ENTITY_FLAG_ACTIVE)
+            continue;
+        if (l[i] < right && r[i] > left && t[i] < bottom && b[i] > top)
+            visible.push_back((int)i);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+class CGameObject;
+typedef CGameObject *LPGAMEOBJECT;
+
+// Entity flags
+#define ENTITY_FLAG_ACTIVE 1      // updated and rendered
+#define ENTITY_FLAG_STATIC 2      // never moves, skipped by Integrate
+#define ENTITY_FLAG_COLLIDABLE 4  // moved by the collision code, skipped by Integrate
+#define ENTITY_FLAG_DELETED 8
+
+/*
+    Entities stored as structure of arrays
+
+    Each hot component lives in its own contiguous array indexed by entity id, so systems like
+    Integrate and UpdateBounds are plain loops over floats: no pointer chasing, no virtual call.
+
+    During the migration, existing CGameObject classes are mirrored through an adapter: AddObject
+    makes an entity owned by the object, Gather copies the objects into the arrays and Scatter
+    writes moved entities back. Native entities (no owner) only live in the arrays.
+
+    Ids are dense and stay valid until Remove, which moves the last entity into the freed id.
+
+    This is a prototype that only the entity bench uses: CPlayScene does not keep its objects
+    here, and there is no collision or animation system yet, so Integrate leaves every collidable
+    entity to the objects' own Update
+*/
+class CEntityStore {
+public:
+    vector<float> x, y;
+    vector<float> vx, vy;
+    vector<float> ax, ay;
+    vector<float> boxOffsetX, boxOffsetY; // left-top corner of the bounding box relative to (x, y)
+    vector<float> boxWidth, boxHeight;
+    vector<float> l, t, r, b; // bounding boxes, see UpdateBounds
+    vector<int> state;
+    vector<int> type;
+    vector<UINT> flags;
+    vector<LPGAMEOBJECT> owner; // object mirrored by the entity, NULL for native entities
+
+    int Add(float x, float y, float boxOffsetX, float boxOffsetY, float boxWidth, float boxHeight,
+            int type, UINT flags = ENTITY_FLAG_ACTIVE);
+    int AddObject(LPGAMEOBJECT obj);
+    void Remove(int id);
+    void Clear();
+    void Reserve(size_t count);
+
+    size_t GetSize() { return x.size(); }
+
+    // Adapter: copy from / back to the owning objects
+    void Gather();
+    void Scatter();
+
+    // Systems
+    void Integrate(DWORD dt);
+    void UpdateBounds();
+    void Cull(float left, float top, float right, float bottom, vector<int> &visible);
+};
+
+typedef CEntityStore *LPENTITYSTORE;
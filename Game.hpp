@@ -13,12 +13,26 @@ using namespace std;
 #include "Scene.hpp"
 #include "Texture.hpp"
 
+// IMPORTANT: this is the only place where a hardcoded file name is allowed !
+#define GAME_FILE L"mario-sample.txt"
+
 #define MAX_FRAME_RATE 100
+
+// The world is always updated by steps of SIMULATION_STEP ms, whatever the frame rate
+#define SIMULATION_STEP 10
 #define KEYBOARD_BUFFER_SIZE 1024
 #define KEYBOARD_STATE_SIZE 256
 
+class CInputRecording;
+typedef CInputRecording *LPINPUTRECORDING;
+
 /*
     Our simple game framework
+
+    Game.cpp holds the scenes and the keyboard handling, GameDevice.cpp the Direct3D device and
+    the DirectInput keyboard. Builds without window (the simulation library, see CMakeLists.txt)
+    link GameHeadless.cpp instead of GameDevice.cpp: nothing is drawn and the keyboard only
+    replays recordings
 */
 class CGame {
     static CGame *__instance;
@@ -27,6 +41,8 @@ class CGame {
     int backBufferWidth = 0; // Backbuffer width & height, will be set during Direct3D initialization
     int backBufferHeight = 0;
 
+    bool isHeadless = false; // see InitHeadless
+
     ID3D10Device *pD3DDevice = NULL;
     IDXGISwapChain *pSwapChain = NULL;
     ID3D10RenderTargetView *pRenderTargetView = NULL;
@@ -42,9 +58,18 @@ class CGame {
 
     LPKEYEVENTHANDLER keyHandler;
 
+    // Keyboard read into a recording, or read from it instead of DirectInput when replaying
+    LPINPUTRECORDING inputRecording = NULL;
+    bool isReplaying = false;
+
+    void DispatchKeyboard(DWORD eventCount);
+    bool ProcessReplayedKeyboard();
+
     float cam_x = 0.0f;
     float cam_y = 0.0f;
 
+    float renderAlpha = 1.0f; // how far rendering is between the last two simulation steps (0..1)
+
     HINSTANCE hInstance;
 
     ID3D10SamplerState *pPointSamplerState;
@@ -60,6 +85,12 @@ public:
     // Init DirectX, Sprite Handler
     void Init(HWND hWnd, HINSTANCE hInstance);
 
+    // Instead of Init, to run scenes without window, device or keyboard: they load and update,
+    // nothing is drawn and no key is down but those replayed. width x height is the view the
+    // camera works with
+    void InitHeadless(int width, int height);
+    bool IsHeadless() { return isHeadless; }
+
     //
     // Draw a portion or ALL the texture at position (x,y) on the screen. (x,y) is at the CENTER of the image
     // rect : if NULL, the whole texture will be drawn
@@ -81,8 +112,28 @@ public:
     void InitKeyboard();
     int IsKeyDown(int KeyCode);
     void ProcessKeyboard();
+    // The keyboard of this frame from a program instead of the device, e.g. to drive a headless
+    // game: recorded like a read one, then handed to the key handler. Ignored when replaying
+    void ProcessKeyboard(const BYTE *states, const DIDEVICEOBJECTDATA *events, DWORD count);
     void SetKeyHandler(LPKEYEVENTHANDLER handler) { keyHandler = handler; }
 
+    // Record the keyboard into recording from now on, or with replay take it from recording (see
+    // CInputRecording::BeginReplay) instead of DirectInput. NULL: back to the plain keyboard
+    void SetInputRecording(LPINPUTRECORDING recording, bool replay) {
+        inputRecording = recording;
+        isReplaying = recording != NULL && replay;
+    }
+    LPINPUTRECORDING GetInputRecording() { return inputRecording; }
+    bool IsReplaying() { return isReplaying; }
+
+    // Switch to the scene recording begins in, put it back in its recorded state and replay the
+    // keyboard from the next ProcessKeyboard on. False when the recording does not fit the game
+    bool StartReplay(LPINPUTRECORDING recording);
+
+    // After the steps simulated for a frame: closes the frame of the recording, or when replaying
+    // checks it ended in the recorded state
+    void RecordFrame(int steps);
+
     ID3D10Device *GetDirect3DDevice() { return this->pD3DDevice; }
     IDXGISwapChain *GetSwapChain() { return this->pSwapChain; }
     ID3D10RenderTargetView *GetRenderTargetView() { return this->pRenderTargetView; }
@@ -107,11 +158,18 @@ public:
         y = cam_y;
     }
 
+    void SetRenderAlpha(float alpha) { renderAlpha = alpha; }
+    float GetRenderAlpha() { return renderAlpha; }
+
     LPSCENE GetCurrentScene() { return scenes[current_scene]; }
+    bool HasScene(int id) { return scenes.find(id) != scenes.end(); }
     void Load(LPCWSTR gameFile);
     void SwitchScene();
     void InitiateSwitchScene(int scene_id);
 
+    void PrefetchScene(int scene_id);
+    void CancelPrefetch();
+
     void _ParseSection_TEXTURES(string line);
 
     ~CGame();
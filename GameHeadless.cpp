@@ -0,0 +1,33 @@
+#include "Game.hpp"
+#include "InputRecording.hpp"
+
+/*
+    What GameDevice.cpp does with Direct3D and DirectInput, for builds without window: there is
+    no device, so CGame is only ever set up by InitHeadless
+*/
+
+void CGame::SetPointSamplerState() {
+}
+
+void CGame::Draw(float x, float y, LPTEXTURE tex, RECT *rect, float alpha, int sprite_width, int sprite_height) {
+}
+
+/*
+    No device to create it on, sprites are created without texture (see CSprite)
+*/
+LPTEXTURE CGame::LoadTexture(LPCWSTR texturePath) {
+    return NULL;
+}
+
+void CGame::InitKeyboard() {
+}
+
+/*
+    No key is down but those of a recording being replayed
+*/
+void CGame::ProcessKeyboard() {
+    ProcessReplayedKeyboard();
+}
+
+CGame::~CGame() {
+}
@@ -9,10 +9,21 @@
 
 CGameObject::CGameObject() {
     x = y = 0;
+    prevX = prevY = 0;
+    simX = simY = 0;
     vx = vy = 0;
     nx = 1;
     state = -1;
+    type = OBJECT_TYPE_UNKNOWN;
+    collisionLayer = COLLISION_LAYER_ALL;
+    collisionMask = COLLISION_LAYER_ALL;
     isDeleted = false;
+    slotMap = NULL;
+    isActive = true;
+    ground = NULL;
+    boxLeft = boxTop = boxRight = boxBottom = 0;
+    boxX = boxY = 0;
+    isBoxDirty = true;
 }
 
 void CGameObject::RenderBoundingBox() {
@@ -23,7 +34,7 @@ void CGameObject::RenderBoundingBox() {
 
     float l, t, r, b;
 
-    GetBoundingBox(l, t, r, b);
+    GetCachedBoundingBox(l, t, r, b);
     rect.left = 0;
     rect.top = 0;
     rect.right = (int)r - (int)l;
@@ -37,3 +48,36 @@ void CGameObject::RenderBoundingBox() {
 
 CGameObject::~CGameObject() {
 }
+
+void CGameObject::Save(CSaveWriter &w) {
+    w.Write(x);
+    w.Write(y);
+    w.Write(vx);
+    w.Write(vy);
+    w.Write((char)nx);
+    w.Write(state);
+    w.Write(collisionLayer);
+    w.Write(collisionMask);
+    w.Write((BYTE)isActive);
+}
+
+/*
+    The object is not in any scene structure yet: collision layer changes are not queued, and
+    the ground is set back by the scene
+*/
+void CGameObject::Restore(CSaveReader &r) {
+    r.Read(x);
+    r.Read(y);
+    r.Read(vx);
+    r.Read(vy);
+    nx = r.Read<char>();
+    r.Read(state);
+    r.Read(collisionLayer);
+    r.Read(collisionMask);
+    isActive = r.Read<BYTE>() != 0;
+
+    prevX = x;
+    prevY = y;
+    SetGround(NULL);
+    isBoxDirty = true;
+}
@@ -6,7 +6,11 @@
 
 #include "Animation.hpp"
 #include "Animations.hpp"
+#include "AssetIDs.hpp"
 #include "Collision.hpp"
+#include "ObjectSlotMap.hpp"
+#include "SaveState.hpp"
+#include "SceneArena.hpp"
 #include "Sprites.hpp"
 
 using namespace std;
@@ -22,12 +26,33 @@ protected:
     float vx;
     float vy;
 
+    float prevX, prevY; // position before the last Update, see BeginRender
+    float simX, simY;   // actual position while rendering
+
     int nx;
 
     int state;
 
+    int type; // OBJECT_TYPE_xxx, set by each object class at construction
+
+    UINT collisionLayer; // COLLISION_LAYER_xxx bit of this object
+    UINT collisionMask;  // layers this object collides with
+
     bool isDeleted;
 
+    LPOBJECTSLOTMAP slotMap; // scene objects this one belongs to, see CObjectSlotMap
+    CObjectHandle handle;
+
+    bool isActive; // sleeping objects are skipped by the scene: no update, collision or rendering
+
+    CGameObject *ground;        // blocking object this one last landed on, see CCollision::IsOnGround
+    CObjectHandle groundHandle; // of ground in slotMap, null when it is not in one
+
+    // Bounding box cache, see GetCachedBoundingBox
+    float boxLeft, boxTop, boxRight, boxBottom;
+    float boxX, boxY; // position the cached box was computed at
+    bool isBoxDirty;
+
 public:
     void SetPosition(float x, float y) { this->x = x, this->y = y; }
     void SetSpeed(float vx, float vy) { this->vx = vx, this->vy = vy; }
@@ -41,21 +66,106 @@ public:
     }
 
     int GetState() { return this->state; }
-    virtual void Delete() { isDeleted = true; }
+    int GetType() { return this->type; }
+
+    UINT GetCollisionLayer() { return collisionLayer; }
+    UINT GetCollisionMask() { return collisionMask; }
+    void SetCollisionLayer(UINT layer, UINT mask) {
+        if (slotMap != NULL && layer != collisionLayer)
+            slotMap->QueueChange(handle);
+        collisionLayer = layer;
+        collisionMask = mask;
+    }
+    // The object is freed at the end of the frame, see CObjectSlotMap::FlushRemovals
+    virtual void Delete() {
+        if (isDeleted)
+            return;
+        isDeleted = true;
+        if (slotMap != NULL)
+            slotMap->DeferRemove(handle);
+    }
     bool IsDeleted() { return isDeleted; }
 
+    CObjectHandle GetHandle() { return handle; }
+    void SetSlot(LPOBJECTSLOTMAP slotMap, CObjectHandle handle) {
+        this->slotMap = slotMap;
+        this->handle = handle;
+    }
+
+    // NULL once a ground of the same scene has been freed: it is looked up by its handle, so the
+    // scene never has to clear the ground of whatever stood on an object it frees
+    CGameObject *GetGround() {
+        if (ground == NULL || slotMap == NULL || groundHandle.IsNull())
+            return ground;
+        return slotMap->Get(groundHandle);
+    }
+    void SetGround(CGameObject *ground) {
+        this->ground = ground;
+        groundHandle = ground != NULL ? ground->GetHandle() : CObjectHandle();
+    }
+
+    bool IsActive() { return isActive; }
+    void SetActive(bool active) { isActive = active; }
+
     void RenderBoundingBox();
 
+    // Remember the current position as the previous simulation state, call before each Update
+    void SavePosition() {
+        prevX = x;
+        prevY = y;
+    }
+
+    // Move the object to where it was at alpha (0..1) between its previous and current position,
+    // so that Render draws smooth motion whatever the display rate. EndRender moves it back
+    void BeginRender(float alpha) {
+        simX = x;
+        simY = y;
+        x = prevX + (x - prevX) * alpha;
+        y = prevY + (y - prevY) * alpha;
+    }
+    void EndRender() {
+        x = simX;
+        y = simY;
+    }
+
+    //
+    // Same as GetBoundingBox, but the box is only computed again once the object moved or its
+    // state changed. Objects whose box depends on anything else (e.g. Mario's level) must call
+    // InvalidateBoundingBox when it changes
+    //
+    void GetCachedBoundingBox(float &left, float &top, float &right, float &bottom) {
+        if (isBoxDirty || boxX != x || boxY != y)
+            RefreshBoundingBox();
+        left = boxLeft;
+        top = boxTop;
+        right = boxRight;
+        bottom = boxBottom;
+    }
+    void RefreshBoundingBox() {
+        GetBoundingBox(boxLeft, boxTop, boxRight, boxBottom);
+        boxX = x;
+        boxY = y;
+        isBoxDirty = false;
+    }
+    void InvalidateBoundingBox() { isBoxDirty = true; }
+
+    // Objects created while a scene loads live in its arena, see CSceneArena
+    static void *operator new(size_t size) { return CSceneArena::New(size); }
+    static void operator delete(void *p, size_t size) { CSceneArena::Delete(p, size); }
+
     CGameObject();
     CGameObject(float x, float y) : CGameObject() {
-        this->x = x;
-        this->y = y;
+        this->x = prevX = x;
+        this->y = prevY = y;
     }
 
     virtual void GetBoundingBox(float &left, float &top, float &right, float &bottom) = 0;
     virtual void Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects = NULL){};
     virtual void Render() = 0;
-    virtual void SetState(int state) { this->state = state; }
+    virtual void SetState(int state) {
+        this->state = state;
+        isBoxDirty = true;
+    }
 
     //
     // Collision ON or OFF ? This can change depending on object's state. For example: die
@@ -71,7 +181,18 @@ public:
     // Is this object blocking other object? If YES, collision framework will automatically push the other object
     virtual int IsBlocking() { return 1; }
 
-    ~CGameObject();
+    // Does this object never move? Static objects are baked into the scene's static collision layer
+    virtual int IsStatic() { return 0; }
+
+    //
+    // Write the state of the object into a save state, and read it back into an object of the same
+    // type (see CPlayScene::SaveState). Subclasses with more state call the base version first,
+    // then write their own fields. Timers are saved as the time elapsed since they started
+    //
+    virtual void Save(CSaveWriter &w);
+    virtual void Restore(CSaveReader &r);
+
+    virtual ~CGameObject();
 
     static bool IsDeleted(const LPGAMEOBJECT &o) { return o->isDeleted; }
 };
@@ -1,9 +1,11 @@
 #include "Goomba.hpp"
 
 CGoomba::CGoomba(float x, float y) : CGameObject(x, y) {
+    this->type = OBJECT_TYPE_GOOMBA;
+    SetCollisionLayer(COLLISION_LAYER_GOOMBA, COLLISION_MASK_GOOMBA);
     this->ax = 0;
     this->ay = GOOMBA_GRAVITY;
-    die_start = -1;
+    die_time = 0;
     SetState(GOOMBA_STATE_WALKING);
 }
 
@@ -29,7 +31,7 @@ void CGoomba::OnNoCollision(DWORD dt) {
 void CGoomba::OnCollisionWith(LPCOLLISIONEVENT e) {
     if (!e->obj->IsBlocking())
         return;
-    if (dynamic_cast<CGoomba *>(e->obj))
+    if (e->obj->GetType() == OBJECT_TYPE_GOOMBA)
         return;
 
     if (e->ny != 0) {
@@ -43,9 +45,12 @@ void CGoomba::Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects) {
     vy += ay * dt;
     vx += ax * dt;
 
-    if ((state == GOOMBA_STATE_DIE) && (GetTickCount64() - die_start > GOOMBA_DIE_TIMEOUT)) {
-        isDeleted = true;
-        return;
+    if (state == GOOMBA_STATE_DIE) {
+        die_time += dt;
+        if (die_time > GOOMBA_DIE_TIMEOUT) {
+            Delete();
+            return;
+        }
     }
 
     CGameObject::Update(dt, coObjects);
@@ -66,14 +71,29 @@ void CGoomba::SetState(int state) {
     CGameObject::SetState(state);
     switch (state) {
     case GOOMBA_STATE_DIE:
-        die_start = GetTickCount64();
+        die_time = 0;
         y += (GOOMBA_BBOX_HEIGHT - GOOMBA_BBOX_HEIGHT_DIE) / 2;
         vx = 0;
         vy = 0;
         ay = 0;
+        SetCollisionLayer(COLLISION_LAYER_NONE, collisionMask); // nothing hits a dead goomba any more
         break;
     case GOOMBA_STATE_WALKING:
         vx = -GOOMBA_WALKING_SPEED;
         break;
     }
 }
+
+void CGoomba::Save(CSaveWriter &w) {
+    CGameObject::Save(w);
+    w.Write(ax);
+    w.Write(ay);
+    w.Write(die_time);
+}
+
+void CGoomba::Restore(CSaveReader &r) {
+    CGameObject::Restore(r);
+    r.Read(ax);
+    r.Read(ay);
+    r.Read(die_time);
+}
@@ -21,7 +21,7 @@ protected:
     float ax;
     float ay;
 
-    ULONGLONG die_start;
+    DWORD die_time; // since dying, in simulation time
 
     virtual void GetBoundingBox(float &left, float &top, float &right, float &bottom);
     virtual void Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects);
@@ -36,4 +36,7 @@ protected:
 public:
     CGoomba(float x, float y);
     virtual void SetState(int state);
+
+    virtual void Save(CSaveWriter &w);
+    virtual void Restore(CSaveReader &r);
 };
@@ -0,0 +1,78 @@
+#include <algorithm>
+
+#include "Game.hpp"
+#include "Headless.hpp"
+#include "InputRecording.hpp"
+#include "PlayScene.hpp"
+#include "debug.hpp"
+
+/*
+    False, after logging why, when the game file did not give a play scene with a player
+*/
+static bool IsSceneLoaded(LPGAME game) {
+    LPPLAYSCENE scene = (LPPLAYSCENE)game->GetCurrentScene();
+    if (scene == NULL || scene->GetPlayer() == NULL) {
+        DebugOut(L"[ERROR] No play scene was loaded\n");
+        return false;
+    }
+    return true;
+}
+
+int RunHeadless(LPCWSTR gameFile, int scene, int frames) {
+    LPGAME game = CGame::GetInstance();
+    game->InitHeadless(HEADLESS_VIEW_WIDTH, HEADLESS_VIEW_HEIGHT);
+    game->Load(gameFile);
+    if (scene >= 0 && !game->HasScene(scene)) {
+        DebugOut(L"[ERROR] The game has no scene %d\n", scene);
+        return 1;
+    }
+    if (scene >= 0) {
+        game->InitiateSwitchScene(scene);
+        game->SwitchScene();
+    }
+    if (!IsSceneLoaded(game))
+        return 1;
+
+    ULONGLONG start = GetTickCount64();
+    for (int i = 0; i < frames; i++) {
+        game->GetCurrentScene()->Update(SIMULATION_STEP);
+        game->SwitchScene();
+    }
+    ULONGLONG elapsed = max(GetTickCount64() - start, (ULONGLONG)1);
+
+    DebugOut(L"[INFO] Headless: %d frames in %d ms, %d frames per second\n", frames, (int)elapsed,
+             (int)(frames * 1000 / elapsed));
+    return 0;
+}
+
+int RunReplay(LPCWSTR gameFile, LPCWSTR recordingFile) {
+    static CInputRecording recording;
+
+    LPGAME game = CGame::GetInstance();
+    game->InitHeadless(HEADLESS_VIEW_WIDTH, HEADLESS_VIEW_HEIGHT);
+    if (!recording.Load(recordingFile))
+        return 1;
+
+    // before the scenes are created, so they keep rewinding if the recording does
+    game->SetInputRecording(&recording, true);
+    game->Load(gameFile);
+    if (!game->StartReplay(&recording))
+        return 1;
+
+    ULONGLONG start = GetTickCount64();
+    int steps = 0;
+    while (!recording.IsReplayDone()) {
+        game->ProcessKeyboard();
+        for (int i = 0; i < recording.GetFrameSteps(); i++)
+            game->GetCurrentScene()->Update(SIMULATION_STEP);
+        steps += recording.GetFrameSteps();
+        game->RecordFrame(recording.GetFrameSteps());
+        game->SwitchScene();
+    }
+    ULONGLONG elapsed = max(GetTickCount64() - start, (ULONGLONG)1);
+
+    DebugOut(L"[INFO] Replay: %d steps (%d ms of play) in %d ms, %.0fx real time\n", steps,
+             steps * SIMULATION_STEP, (int)elapsed, (double)steps * SIMULATION_STEP / elapsed);
+    recording.Report();
+    return recording.GetMismatchCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <windows.h>
+
+// Steps simulated by RunHeadless unless told otherwise
+#define HEADLESS_FRAMES 100000
+
+// The view the camera works with, as the game window
+#define HEADLESS_VIEW_WIDTH 320
+#define HEADLESS_VIEW_HEIGHT 240
+
+/*
+    Running the game without window, device or keyboard (see CGame::InitHeadless), from the
+    Windows game (-headless) or from the headless tool of the CMake build (HeadlessMain.cpp).
+    Both return the exit code of the program: 0 on success
+*/
+
+// Step a scene of gameFile frames times as fast as the CPU allows and report how many simulated
+// frames per second that is. scene: id of the scene to run, -1 for the start scene of the game
+int RunHeadless(LPCWSTR gameFile, int scene, int frames = HEADLESS_FRAMES);
+
+// Replay the recording in recordingFile (see CInputRecording) as fast as the CPU allows,
+// checking every frame against the recorded state. 0 when the whole replay matched
+int RunReplay(LPCWSTR gameFile, LPCWSTR recordingFile);
@@ -0,0 +1,29 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "Game.hpp"
+#include "Headless.hpp"
+#include "Utils.hpp"
+#include "debug.hpp"
+
+/*
+    The headless tool of the CMake build: the game without window, device or keyboard, on any
+    platform the simulation builds on. Run from the directory of the game file
+
+    headless [scene id] [frames]: step a scene as fast as possible, see RunHeadless
+    headless -replay file: check a recording made with the game's -record, see RunReplay
+*/
+int main(int argc, char *argv[]) {
+    SetDebugConsole(true);
+
+    if (argc == 3 && strcmp(argv[1], "-replay") == 0)
+        return RunReplay(GAME_FILE, ToWSTR(argv[2]).c_str());
+
+    int scene = argc > 1 ? atoi(argv[1]) : -1;
+    int frames = argc > 2 ? atoi(argv[2]) : HEADLESS_FRAMES;
+    if (frames <= 0) {
+        DebugOut(L"[ERROR] Usage: headless [scene id] [frames] | headless -replay file\n");
+        return 2;
+    }
+    return RunHeadless(GAME_FILE, scene, frames);
+}
@@ -0,0 +1,217 @@
+#include <cstring>
+#include <fstream>
+
+#include "InputRecording.hpp"
+#include "PlayScene.hpp"
+#include "SaveState.hpp"
+#include "Utils.hpp"
+#include "debug.hpp"
+
+CInputRecording::CInputRecording() {
+    sceneId = -1;
+    position = frame = 0;
+    frameSteps = 0;
+    mismatches = firstMismatch = 0;
+    ClearKeys();
+}
+
+void CInputRecording::ClearKeys() {
+    memset(keys, 0, sizeof(keys));
+}
+
+void CInputRecording::Begin(LPPLAYSCENE scene) {
+    sceneId = scene->GetId();
+    scene->GetRewindBuffer()->Clear();
+    scene->SetRewinding(false);
+    scene->SaveState(startState);
+
+    frames.clear();
+    hashes.clear();
+    ClearKeys();
+}
+
+/*
+    Only whether a key is down matters to the key handlers, so a key state is kept as its 0x80 bit.
+    The frame starts with 0 when the keyboard was not read, else with 1 + the keys that changed
+*/
+void CInputRecording::RecordKeyboard(const BYTE *states, const DIDEVICEOBJECTDATA *events, DWORD count) {
+    if (states == NULL) {
+        WriteVarint(frames, 0);
+        return;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < KEYBOARD_STATE_SIZE; i++) {
+        if ((states[i] & 0x80) != keys[i])
+            changed++;
+    }
+
+    WriteVarint(frames, 1 + changed);
+    for (int i = 0; i < KEYBOARD_STATE_SIZE; i++) {
+        if ((states[i] & 0x80) != keys[i]) {
+            frames.push_back((BYTE)i);
+            keys[i] = states[i] & 0x80;
+        }
+    }
+
+    WriteVarint(frames, count);
+    for (DWORD i = 0; i < count; i++)
+        WriteVarint(frames, (events[i].dwOfs << 1) | ((events[i].dwData & 0x80) != 0 ? 1 : 0));
+}
+
+void CInputRecording::RecordSteps(int steps, UINT64 hash) {
+    WriteVarint(frames, steps);
+    hashes.push_back(hash);
+}
+
+bool CInputRecording::BeginReplay(LPPLAYSCENE scene) {
+    position = frame = 0;
+    frameSteps = 0;
+    mismatches = firstMismatch = 0;
+    ClearKeys();
+
+    if (scene->GetId() != sceneId) {
+        DebugOut(L"[ERROR] Recording begins in scene %d, not in scene %d\n", sceneId, scene->GetId());
+        position = frames.size();
+        return false;
+    }
+
+    scene->GetRewindBuffer()->Clear();
+    scene->SetRewinding(false);
+    if (!scene->RestoreState(startState)) {
+        position = frames.size();
+        return false;
+    }
+    return true;
+}
+
+bool CInputRecording::ReplayKeyboard(BYTE *states, DIDEVICEOBJECTDATA *events, DWORD &count) {
+    count = 0;
+    if (IsReplayDone())
+        return false;
+
+    const BYTE *p = &frames[position];
+    const BYTE *end = &frames[0] + frames.size();
+
+    size_t changed = ReadVarint(p, end);
+    bool isRead = changed > 0;
+    if (isRead) {
+        for (size_t i = 1; i < changed && p < end; i++) {
+            BYTE key = *p++;
+            keys[key] ^= 0x80;
+        }
+        memcpy(states, keys, sizeof(keys));
+
+        count = (DWORD)min(ReadVarint(p, end), (size_t)KEYBOARD_BUFFER_SIZE);
+        for (DWORD i = 0; i < count; i++) {
+            size_t event = ReadVarint(p, end);
+            events[i].dwOfs = (DWORD)(event >> 1);
+            events[i].dwData = (event & 1) != 0 ? 0x80 : 0;
+        }
+    }
+
+    frameSteps = (int)ReadVarint(p, end);
+    position = p - &frames[0];
+    return isRead;
+}
+
+bool CInputRecording::VerifySteps(UINT64 hash) {
+    size_t i = frame++;
+    if (i < hashes.size() && hashes[i] == hash)
+        return true;
+
+    if (mismatches++ == 0) {
+        firstMismatch = i;
+        DebugOut(L"[ERROR] Replay went off the recording at frame %d\n", (int)i);
+    }
+    return false;
+}
+
+void CInputRecording::Report() {
+    if (mismatches == 0)
+        DebugOut(L"[INFO] Replay: %d frames, all matching the recording\n", (int)frame);
+    else
+        DebugOut(L"[ERROR] Replay: %d of %d frames off the recording, from frame %d\n", (int)mismatches, (int)frame,
+                 (int)firstMismatch);
+}
+
+/*
+    Layout: magic, version, scene id, frame count, bytes of start state and of encoded frames,
+    then the start state, the frames and the hash of each frame
+*/
+bool CInputRecording::Save(LPCWSTR path) {
+    vector<BYTE> data;
+    CSaveWriter w(data);
+    w.Write((UINT)INPUT_RECORDING_MAGIC);
+    w.Write((UINT)INPUT_RECORDING_VERSION);
+    w.Write(sceneId);
+    w.Write((UINT)hashes.size());
+    w.Write((UINT)startState.size());
+    w.Write((UINT)frames.size());
+    w.Close();
+
+    ofstream f;
+    OpenFile(f, path, ios::binary);
+    if (!f) {
+        DebugOut(L"[ERROR] Cannot write recording %s\n", path);
+        return false;
+    }
+    f.write((const char *)&data[0], data.size());
+    if (!startState.empty())
+        f.write((const char *)&startState[0], startState.size());
+    if (!frames.empty())
+        f.write((const char *)&frames[0], frames.size());
+    if (!hashes.empty())
+        f.write((const char *)&hashes[0], hashes.size() * sizeof(UINT64));
+    f.close();
+
+    DebugOut(L"[INFO] Recording of %d frames saved to %s: %d bytes of input, %d of start state\n",
+             (int)hashes.size(), path, (int)frames.size(), (int)startState.size());
+    return true;
+}
+
+bool CInputRecording::Load(LPCWSTR path) {
+    ifstream f;
+    OpenFile(f, path, ios::binary);
+    if (!f) {
+        DebugOut(L"[ERROR] Cannot read recording %s\n", path);
+        return false;
+    }
+
+    vector<BYTE> header(6 * sizeof(UINT));
+    f.read((char *)&header[0], header.size());
+
+    CSaveReader r(header);
+    UINT magic = r.Read<UINT>();
+    UINT version = r.Read<UINT>();
+    int scene = r.Read<int>();
+    UINT frameCount = r.Read<UINT>();
+    UINT stateSize = r.Read<UINT>();
+    UINT frameSize = r.Read<UINT>();
+    if (!f || magic != INPUT_RECORDING_MAGIC || version != INPUT_RECORDING_VERSION) {
+        DebugOut(L"[ERROR] %s is not a recording of version %d\n", path, INPUT_RECORDING_VERSION);
+        return false;
+    }
+
+    startState.resize(stateSize);
+    frames.resize(frameSize);
+    hashes.resize(frameCount);
+    if (stateSize > 0)
+        f.read((char *)&startState[0], stateSize);
+    if (frameSize > 0)
+        f.read((char *)&frames[0], frameSize);
+    if (frameCount > 0)
+        f.read((char *)&hashes[0], frameCount * sizeof(UINT64));
+    if (!f) {
+        DebugOut(L"[ERROR] Recording %s is truncated\n", path);
+        startState.clear();
+        frames.clear();
+        hashes.clear();
+        return false;
+    }
+    f.close();
+
+    sceneId = scene;
+    position = frames.size(); // until BeginReplay
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+#include "Game.hpp"
+
+using namespace std;
+
+#define INPUT_RECORDING_MAGIC 0x504E494D // "MINP"
+
+// Bump whenever the layout of a recording changes: older recordings are then refused
+#define INPUT_RECORDING_VERSION 1
+
+class CPlayScene;
+typedef CPlayScene *LPPLAYSCENE;
+
+/*
+    The keyboard input of a play session frame by frame, to play the session again exactly
+
+    A frame is what CGame::ProcessKeyboard read (the keys that changed state since the previous
+    frame and the buffered key events, as varints, or that the keyboard could not be read) and
+    the number of simulation steps run after it. The simulation only depends on that and on the
+    scene it started from, whose save state is kept with the recording, so replaying the frames
+    in order gives the same session bit for bit, whatever the frame rate or machine load. Quiet
+    frames take 3 bytes.
+
+    Each frame also keeps the hash of the scene state after its steps (see
+    CPlayScene::GetStateHash): a replay checks its own against them and reports the first frame
+    that went another way
+*/
+class CInputRecording {
+    int sceneId;
+    vector<BYTE> startState;
+
+    vector<BYTE> frames;   // encoded frames
+    vector<UINT64> hashes; // one per frame
+
+    BYTE keys[KEYBOARD_STATE_SIZE]; // key states of the last frame recorded or replayed
+
+    // replay
+    size_t position; // in frames
+    size_t frame;    // frames replayed
+    int frameSteps;
+    size_t mismatches;
+    size_t firstMismatch;
+
+    void ClearKeys();
+
+public:
+    CInputRecording();
+
+    // Start a new recording from the scene as it is now. Its rewind buffer is cleared, as what
+    // was captured before could not be replayed
+    void Begin(LPPLAYSCENE scene);
+
+    // The keyboard as read for this frame: the state of every key and count buffered events.
+    // states NULL: the keyboard could not be read in this frame
+    void RecordKeyboard(const BYTE *states, const DIDEVICEOBJECTDATA *events, DWORD count);
+
+    // Close the frame: the steps simulated after its input and the state hash after them
+    void RecordSteps(int steps, UINT64 hash);
+
+    // Put the scene back as it was when recording began and replay from the first frame. False
+    // when scene is not the one the recording began in or its state cannot be restored
+    bool BeginReplay(LPPLAYSCENE scene);
+
+    // The keyboard of the next frame, into the buffers CGame reads DirectInput into. False, with
+    // nothing for the key handlers, when it was not read in that frame or once every frame has
+    // been replayed
+    bool ReplayKeyboard(BYTE *states, DIDEVICEOBJECTDATA *events, DWORD &count);
+
+    // Steps to simulate after the keyboard just replayed
+    int GetFrameSteps() { return frameSteps; }
+
+    // Compare the state after the steps of the frame just replayed with the recorded one. False
+    // on a mismatch, the first of which is logged
+    bool VerifySteps(UINT64 hash);
+
+    // Log how the replay compared with the recording
+    void Report();
+
+    bool IsReplayDone() { return position >= frames.size(); }
+
+    size_t GetFrameCount() { return hashes.size(); }
+    size_t GetReplayedFrameCount() { return frame; }
+    size_t GetMismatchCount() { return mismatches; }
+    size_t GetFirstMismatch() { return firstMismatch; } // frame index, only with mismatches
+    int GetSceneId() { return sceneId; }
+    size_t GetSize() { return frames.size(); }
+
+    bool Save(LPCWSTR path);
+    bool Load(LPCWSTR path);
+};
+
+typedef CInputRecording *LPINPUTRECORDING;
@@ -10,6 +10,7 @@ public:
     virtual void KeyState(BYTE *state) = 0;
     virtual void OnKeyDown(int KeyCode) = 0;
     virtual void OnKeyUp(int KeyCode) = 0;
+    virtual ~CKeyEventHandler() {}
 };
 
 typedef CKeyEventHandler *LPKEYEVENTHANDLER;
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cmath>
+
+#include "GameObject.hpp"
+#include "LevelStream.hpp"
+
+CLevelStream::CLevelStream() {
+    objects = NULL;
+    budget = LEVEL_STREAM_BUDGET;
+    resident = 0;
+    loads = evictions = 0;
+}
+
+void CLevelStream::Add(const string &line, float l, float r) {
+    int index = (int)floor(l / LEVEL_CHUNK_WIDTH);
+
+    auto it = chunks.find(index);
+    if (it == chunks.end()) {
+        CChunk chunk;
+        chunk.index = index;
+        chunk.l = index * LEVEL_CHUNK_WIDTH;
+        chunk.r = chunk.l + LEVEL_CHUNK_WIDTH;
+        chunk.status = LEVEL_CHUNK_UNLOADED;
+        chunk.cursor = 0;
+        chunk.resident = 0;
+        it = chunks.insert(make_pair(index, chunk)).first;
+    }
+
+    // objects wider than a chunk make theirs reach further
+    CChunk &chunk = it->second;
+    chunk.l = min(chunk.l, l);
+    chunk.r = max(chunk.r, r);
+
+    CRecord record;
+    record.line = line;
+    record.isGone = false;
+    record.hasState = false;
+    record.x = record.y = record.vx = record.vy = 0;
+    record.state = -1;
+
+    chunk.records.push_back((UINT)records.size());
+    records.push_back(record);
+}
+
+float CLevelStream::GetDistance(const CChunk &chunk, float l, float r) {
+    if (chunk.r < l)
+        return l - chunk.r;
+    if (chunk.l > r)
+        return chunk.l - r;
+    return 0;
+}
+
+/*
+    Pick the chunks to load and evict, then spend the frame's steps on them: loads first, nearest
+    chunk first, then evictions, farthest chunk first. A chunk that gets back into the window
+    while being evicted is loaded again from where it stands
+*/
+size_t CLevelStream::Update(float l, float r, size_t maxSteps, vector<LPGAMEOBJECT> &spawned) {
+    float wl = l - LEVEL_STREAM_MARGIN;
+    float wr = r + LEVEL_STREAM_MARGIN;
+
+    size_t leaving = 0; // resident objects of the chunks already being evicted
+    evictable.clear();
+
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        CChunk &chunk = it->second;
+        bool isWanted = chunk.r >= wl && chunk.l <= wr;
+
+        if (isWanted && (chunk.status == LEVEL_CHUNK_UNLOADED || chunk.status == LEVEL_CHUNK_EVICTING)) {
+            chunk.status = LEVEL_CHUNK_LOADING;
+            chunk.cursor = 0;
+        } else if (!isWanted && chunk.status == LEVEL_CHUNK_LOADED)
+            evictable.push_back(&chunk);
+
+        if (chunk.status == LEVEL_CHUNK_EVICTING)
+            leaving += chunk.resident;
+    }
+
+    if (resident - leaving > budget) {
+        sort(evictable.begin(), evictable.end(), [wl, wr](const CChunk *a, const CChunk *b) {
+            float da = GetDistance(*a, wl, wr), db = GetDistance(*b, wl, wr);
+            return da != db ? da > db : a->index < b->index;
+        });
+
+        for (size_t i = 0; i < evictable.size() && resident - leaving > budget; i++) {
+            evictable[i]->status = LEVEL_CHUNK_EVICTING;
+            evictable[i]->cursor = 0;
+            leaving += evictable[i]->resident;
+        }
+    }
+
+    work.clear();
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        int status = it->second.status;
+        if (status == LEVEL_CHUNK_LOADING || status == LEVEL_CHUNK_EVICTING)
+            work.push_back(&it->second);
+    }
+
+    sort(work.begin(), work.end(), [wl, wr](const CChunk *a, const CChunk *b) {
+        if (a->status != b->status)
+            return a->status == LEVEL_CHUNK_LOADING;
+        float da = GetDistance(*a, wl, wr), db = GetDistance(*b, wl, wr);
+        if (da != db)
+            return a->status == LEVEL_CHUNK_LOADING ? da < db : da > db;
+        return a->index < b->index;
+    });
+
+    size_t steps = 0;
+    for (size_t i = 0; i < work.size() && steps < maxSteps; i++) {
+        CChunk &chunk = *work[i];
+        while (steps < maxSteps) {
+            bool done = chunk.status == LEVEL_CHUNK_LOADING ? !LoadStep(chunk, spawned) : !EvictStep(chunk);
+            if (done)
+                break;
+            steps++;
+        }
+    }
+
+    return steps;
+}
+
+void CLevelStream::LoadAll(vector<LPGAMEOBJECT> &spawned) {
+    work.clear();
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        it->second.status = LEVEL_CHUNK_LOADING;
+        it->second.cursor = 0;
+        work.push_back(&it->second);
+    }
+
+    // same order as the level file, chunk by chunk
+    sort(work.begin(), work.end(), [](const CChunk *a, const CChunk *b) { return a->index < b->index; });
+
+    for (size_t i = 0; i < work.size(); i++)
+        while (LoadStep(*work[i], spawned))
+            ;
+}
+
+/*
+    Create the next object of a loading chunk. False once the chunk is loaded
+*/
+bool CLevelStream::LoadStep(CChunk &chunk, vector<LPGAMEOBJECT> &spawned) {
+    while (chunk.cursor < chunk.records.size()) {
+        CRecord &record = records[chunk.records[chunk.cursor++]];
+        if (record.isGone || !record.handle.IsNull())
+            continue;
+
+        LPGAMEOBJECT obj = spawn(record.line);
+        if (obj == NULL) {
+            record.isGone = true;
+            return true;
+        }
+
+        if (record.hasState) {
+            if (obj->GetState() != record.state)
+                obj->SetState(record.state);
+            obj->SetPosition(record.x, record.y);
+            obj->SetSpeed(record.vx, record.vy);
+            obj->SavePosition();
+        }
+
+        record.handle = obj->GetHandle();
+        chunk.resident++;
+        resident++;
+        loads++;
+        spawned.push_back(obj);
+        return true;
+    }
+
+    chunk.status = LEVEL_CHUNK_LOADED;
+    return false;
+}
+
+/*
+    Take the next object of an evicting chunk out of the scene. False once the chunk is unloaded
+*/
+bool CLevelStream::EvictStep(CChunk &chunk) {
+    while (chunk.cursor < chunk.records.size()) {
+        CRecord &record = records[chunk.records[chunk.cursor++]];
+        if (record.handle.IsNull())
+            continue;
+
+        Evict(record);
+        chunk.resident--;
+        resident--;
+        evictions++;
+        return true;
+    }
+
+    chunk.status = LEVEL_CHUNK_UNLOADED;
+    return false;
+}
+
+void CLevelStream::Evict(CRecord &record) {
+    LPGAMEOBJECT obj = objects->Get(record.handle);
+    record.handle = CObjectHandle();
+
+    // freed, deleted or dead (off every collision layer, see CGoomba::SetState) since it loaded
+    if (obj == NULL || obj->IsDeleted() || obj->GetCollisionLayer() == COLLISION_LAYER_NONE) {
+        record.isGone = true;
+        if (obj != NULL)
+            obj->Delete();
+        return;
+    }
+
+    obj->GetPosition(record.x, record.y);
+    obj->GetSpeed(record.vx, record.vy);
+    record.state = obj->GetState();
+    record.hasState = true;
+
+    obj->Delete();
+}
+
+void CLevelStream::Clear() {
+    records.clear();
+    chunks.clear();
+    work.clear();
+    evictable.clear();
+    resident = 0;
+}
+
+#define LEVEL_RECORD_GONE 1
+#define LEVEL_RECORD_STATE 2
+
+void CLevelStream::Save(CSaveWriter &w, const vector<int> &savedIndices) {
+    w.Write((UINT)records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        CRecord &record = records[i];
+        BYTE flags = (record.isGone ? LEVEL_RECORD_GONE : 0) | (record.hasState ? LEVEL_RECORD_STATE : 0);
+        w.Write(flags);
+        if (record.hasState) {
+            w.Write(record.x);
+            w.Write(record.y);
+            w.Write(record.vx);
+            w.Write(record.vy);
+            w.Write(record.state);
+        }
+        int index = objects->GetIndex(record.handle);
+        w.Write(index >= 0 ? savedIndices[index] : -1);
+    }
+
+    w.Write((UINT)chunks.size());
+    for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+        w.Write(it->second.index);
+        w.Write((BYTE)it->second.status);
+        w.Write((UINT)it->second.cursor);
+        w.Write((UINT)it->second.resident);
+    }
+}
+
+bool CLevelStream::Check(CSaveReader &r, size_t objectCount) {
+    if (r.Read<UINT>() != records.size())
+        return false;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        BYTE flags = r.Read<BYTE>();
+        if ((flags & LEVEL_RECORD_STATE) != 0)
+            r.Skip(4 * sizeof(float) + sizeof(int));
+
+        int index = r.Read<int>();
+        if (index < -1 || index >= (int)objectCount)
+            return false;
+    }
+
+    if (r.Read<UINT>() != chunks.size())
+        return false;
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunks.find(r.Read<int>()) == chunks.end())
+            return false;
+        r.Skip(sizeof(BYTE) + 2 * sizeof(UINT));
+    }
+
+    return r.IsValid();
+}
+
+void CLevelStream::Restore(CSaveReader &r, const vector<LPGAMEOBJECT> &restored) {
+    r.Read<UINT>(); // record count, checked
+
+    for (size_t i = 0; i < records.size(); i++) {
+        CRecord &record = records[i];
+        BYTE flags = r.Read<BYTE>();
+        record.isGone = (flags & LEVEL_RECORD_GONE) != 0;
+        record.hasState = (flags & LEVEL_RECORD_STATE) != 0;
+        if (record.hasState) {
+            r.Read(record.x);
+            r.Read(record.y);
+            r.Read(record.vx);
+            r.Read(record.vy);
+            r.Read(record.state);
+        }
+
+        int index = r.Read<int>();
+        record.handle = index >= 0 ? restored[index]->GetHandle() : CObjectHandle();
+    }
+
+    r.Read<UINT>(); // chunk count, checked
+
+    resident = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        CChunk &chunk = chunks[r.Read<int>()];
+        chunk.status = r.Read<BYTE>();
+        chunk.cursor = r.Read<UINT>();
+        chunk.resident = r.Read<UINT>();
+        resident += chunk.resident;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+
+#include "ObjectSlotMap.hpp"
+#include "SaveState.hpp"
+
+using namespace std;
+
+#define LEVEL_CHUNK_WIDTH 512.0f
+
+// Chunks within this distance (in pixels) of the camera view get loaded. Keep it well above
+// ACTIVATION_MARGIN, so that a chunk is complete before its objects wake up
+#define LEVEL_STREAM_MARGIN 256.0f
+
+// Streamed objects kept in memory before chunks out of the camera window get evicted
+#define LEVEL_STREAM_BUDGET 1024
+
+// Objects created or evicted per frame at most, so that streaming never stalls a frame
+#define LEVEL_STREAM_STEPS_PER_FRAME 16
+
+#define LEVEL_CHUNK_UNLOADED 0
+#define LEVEL_CHUNK_LOADING 1
+#define LEVEL_CHUNK_LOADED 2
+#define LEVEL_CHUNK_EVICTING 3
+
+// Create the object of an [OBJECTS] line and insert it into the scene objects, NULL for an
+// invalid line
+typedef function<LPGAMEOBJECT(const string &line)> LEVELSTREAMSPAWN;
+
+/*
+    Objects of a level, kept as the scene file lines they are created from and partitioned into
+    fixed-width chunks along X
+
+    Chunks around the camera are loaded, and once more objects than the budget are resident the
+    chunks out of the camera window are evicted, farthest first. Both are done a few objects per
+    frame. An evicted object remembers its position, speed and state for the next time its chunk
+    loads, and objects gone while resident (collected coins, killed enemies) never come back.
+
+    An object stays in the chunk it was placed in by the level, wherever it walks to
+*/
+class CLevelStream {
+    struct CRecord {
+        string line;
+        CObjectHandle handle; // null while not resident
+        bool isGone;
+        bool hasState;        // saved when evicted
+        float x, y, vx, vy;
+        int state;
+    };
+
+    struct CChunk {
+        int index;
+        vector<UINT> records;
+        float l, r;      // x range covered by the objects of the chunk
+        int status;      // LEVEL_CHUNK_xxx
+        size_t cursor;   // next record to load or evict
+        size_t resident; // records with an object
+    };
+
+    vector<CRecord> records;
+    unordered_map<int, CChunk> chunks;
+    vector<CChunk *> work;      // chunks being loaded or evicted, in the order to process them
+    vector<CChunk *> evictable; // loaded chunks out of the camera window
+
+    LPOBJECTSLOTMAP objects;
+    LEVELSTREAMSPAWN spawn;
+
+    size_t budget;
+    size_t resident;
+    size_t loads, evictions;
+
+    bool LoadStep(CChunk &chunk, vector<LPGAMEOBJECT> &spawned);
+    bool EvictStep(CChunk &chunk);
+    void Evict(CRecord &record);
+
+    static float GetDistance(const CChunk &chunk, float l, float r);
+
+public:
+    CLevelStream();
+
+    // Objects are created by spawn and looked up in objects, evicted ones are Delete()d so the
+    // scene frees them with its other deleted objects
+    void SetScene(LPOBJECTSLOTMAP objects, const LEVELSTREAMSPAWN &spawn) {
+        this->objects = objects;
+        this->spawn = spawn;
+    }
+
+    void SetBudget(size_t budget) { this->budget = budget; }
+
+    // Add the object of a scene file line covering [l, r] along X
+    void Add(const string &line, float l, float r);
+
+    // Stream the chunks for a camera view spanning [l, r] along X, doing at most maxSteps
+    // object loads and evictions. The objects created are appended to spawned, with their saved
+    // state back, for the scene to register them. Returns the number of steps done
+    size_t Update(float l, float r, size_t maxSteps, vector<LPGAMEOBJECT> &spawned);
+
+    // Make every chunk resident at once, for scenes that do not stream
+    void LoadAll(vector<LPGAMEOBJECT> &spawned);
+
+    // Forget the level, objects must have been freed before
+    void Clear();
+
+    // Write what has been streamed so far, resident objects by their index among the saved objects:
+    // savedIndices maps an index in the scene objects to it, -1 for an object that is not saved.
+    // Restore needs the same level, and the objects restored in the same order. Check reads what
+    // Save wrote without changing anything, false when it does not fit this level and objectCount
+    // objects: Restore must only be given what passed it
+    void Save(CSaveWriter &w, const vector<int> &savedIndices);
+    bool Check(CSaveReader &r, size_t objectCount);
+    void Restore(CSaveReader &r, const vector<LPGAMEOBJECT> &restored);
+
+    size_t GetRecordCount() { return records.size(); }
+    size_t GetResidentCount() { return resident; }
+    size_t GetChunkCount() { return chunks.size(); }
+    size_t GetLoadCount() { return loads; }
+    size_t GetEvictionCount() { return evictions; }
+};
+
+typedef CLevelStream *LPLEVELSTREAM;
@@ -9,6 +9,7 @@
 #include "Portal.hpp"
 
 #include "Collision.hpp"
+#include "CollisionDispatch.hpp"
 
 void CMario::Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects) {
     vy += ay * dt;
@@ -17,10 +18,14 @@ void CMario::Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects) {
     if (abs(vx) > abs(maxVx))
         vx = maxVx;
 
-    // reset untouchable timer if untouchable time has passed
-    if (GetTickCount64() - untouchable_start > MARIO_UNTOUCHABLE_TIME) {
-        untouchable_start = 0;
-        untouchable = 0;
+    // reset untouchable timer if untouchable time has passed. Timed by the steps simulated, not
+    // by the wall clock, so that it lasts as many frames however fast the simulation runs
+    if (untouchable) {
+        untouchable_time += dt;
+        if (untouchable_time > MARIO_UNTOUCHABLE_TIME) {
+            untouchable_time = 0;
+            untouchable = 0;
+        }
     }
 
     isOnPlatform = false;
@@ -42,16 +47,31 @@ void CMario::OnCollisionWith(LPCOLLISIONEVENT e) {
         vx = 0;
     }
 
-    if (dynamic_cast<CGoomba *>(e->obj))
-        OnCollisionWithGoomba(e);
-    else if (dynamic_cast<CCoin *>(e->obj))
-        OnCollisionWithCoin(e);
-    else if (dynamic_cast<CPortal *>(e->obj))
-        OnCollisionWithPortal(e);
+    CCollisionDispatch::GetInstance()->Dispatch(this, e);
+}
+
+/*
+    The table is written by the first call only, through the initialization of a local static,
+    which C++ runs exactly once even when scenes are created on several threads. Later calls do
+    not touch the table, so they do not race with scenes reading it on the worker pool
+*/
+void CMario::RegisterCollisionHandlers() {
+    static bool isRegistered = [] {
+        CCollisionDispatch *dispatch = CCollisionDispatch::GetInstance();
+
+        dispatch->Register(OBJECT_TYPE_MARIO, OBJECT_TYPE_GOOMBA,
+                           [](LPGAMEOBJECT src, LPCOLLISIONEVENT e) { ((CMario *)src)->OnCollisionWithGoomba(e); });
+        dispatch->Register(OBJECT_TYPE_MARIO, OBJECT_TYPE_COIN,
+                           [](LPGAMEOBJECT src, LPCOLLISIONEVENT e) { ((CMario *)src)->OnCollisionWithCoin(e); });
+        dispatch->Register(OBJECT_TYPE_MARIO, OBJECT_TYPE_PORTAL,
+                           [](LPGAMEOBJECT src, LPCOLLISIONEVENT e) { ((CMario *)src)->OnCollisionWithPortal(e); });
+        return true;
+    }();
+    (void)isRegistered;
 }
 
 void CMario::OnCollisionWithGoomba(LPCOLLISIONEVENT e) {
-    CGoomba *goomba = dynamic_cast<CGoomba *>(e->obj);
+    CGoomba *goomba = (CGoomba *)e->obj;
 
     // jump on top >> kill Goomba and deflect a bit
     if (e->ny < 0) {
@@ -65,6 +85,7 @@ void CMario::OnCollisionWithGoomba(LPCOLLISIONEVENT e) {
             if (goomba->GetState() != GOOMBA_STATE_DIE) {
                 if (level > MARIO_LEVEL_SMALL) {
                     level = MARIO_LEVEL_SMALL;
+                    InvalidateBoundingBox();
                     StartUntouchable();
                 } else {
                     DebugOut(L">>> Mario DIE >>> \n");
@@ -82,7 +103,7 @@ void CMario::OnCollisionWithCoin(LPCOLLISIONEVENT e) {
 
 void CMario::OnCollisionWithPortal(LPCOLLISIONEVENT e) {
     CPortal *p = (CPortal *)e->obj;
-    CGame::GetInstance()->InitiateSwitchScene(p->GetSceneId());
+    portalSceneId = p->GetSceneId();
 }
 
 //
@@ -203,6 +224,27 @@ void CMario::Render() {
     DebugOutTitle(L"Coins: %d", coin);
 }
 
+void CMario::SetInput(int input, int previous) {
+    int pressed = input & ~previous;
+    int released = previous & ~input;
+
+    if (pressed & MARIO_INPUT_SIT)
+        SetState(MARIO_STATE_SIT);
+    if (pressed & MARIO_INPUT_JUMP)
+        SetState(MARIO_STATE_JUMP);
+    if (released & MARIO_INPUT_JUMP)
+        SetState(MARIO_STATE_RELEASE_JUMP);
+    if (released & MARIO_INPUT_SIT)
+        SetState(MARIO_STATE_SIT_RELEASE);
+
+    if (input & MARIO_INPUT_RIGHT)
+        SetState(input & MARIO_INPUT_RUN ? MARIO_STATE_RUNNING_RIGHT : MARIO_STATE_WALKING_RIGHT);
+    else if (input & MARIO_INPUT_LEFT)
+        SetState(input & MARIO_INPUT_RUN ? MARIO_STATE_RUNNING_LEFT : MARIO_STATE_WALKING_LEFT);
+    else
+        SetState(MARIO_STATE_IDLE);
+}
+
 void CMario::SetState(int state) {
     // DIE is the end state, cannot be changed!
     if (this->state == MARIO_STATE_DIE)
@@ -280,6 +322,7 @@ void CMario::SetState(int state) {
         vy = -MARIO_JUMP_DEFLECT_SPEED;
         vx = 0;
         ax = 0;
+        SetCollisionLayer(COLLISION_LAYER_NONE, collisionMask);
         break;
     }
 
@@ -313,4 +356,31 @@ void CMario::SetLevel(int l) {
         y -= (MARIO_BIG_BBOX_HEIGHT - MARIO_SMALL_BBOX_HEIGHT) / 2;
     }
     level = l;
+    InvalidateBoundingBox();
+}
+
+void CMario::Save(CSaveWriter &w) {
+    CGameObject::Save(w);
+    w.Write(isSitting);
+    w.Write(maxVx);
+    w.Write(ax);
+    w.Write(ay);
+    w.Write(level);
+    w.Write(untouchable);
+    w.Write(untouchable_time);
+    w.Write(isOnPlatform);
+    w.Write(coin);
+}
+
+void CMario::Restore(CSaveReader &r) {
+    CGameObject::Restore(r);
+    r.Read(isSitting);
+    r.Read(maxVx);
+    r.Read(ax);
+    r.Read(ay);
+    r.Read(level);
+    r.Read(untouchable);
+    r.Read(untouchable_time);
+    r.Read(isOnPlatform);
+    r.Read(coin);
 }
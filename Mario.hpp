@@ -33,6 +33,13 @@
 #define MARIO_STATE_SIT 600
 #define MARIO_STATE_SIT_RELEASE 601
 
+// Buttons held, see CMario::SetInput
+#define MARIO_INPUT_LEFT 0x01
+#define MARIO_INPUT_RIGHT 0x02
+#define MARIO_INPUT_RUN 0x04
+#define MARIO_INPUT_JUMP 0x08
+#define MARIO_INPUT_SIT 0x10
+
 #pragma region ANIMATION_ID
 
 #define ID_ANI_MARIO_IDLE_RIGHT 400
@@ -104,10 +111,12 @@ class CMario : public CGameObject {
 
     int level;
     int untouchable;
-    ULONGLONG untouchable_start;
+    DWORD untouchable_time; // since StartUntouchable, in simulation time
     BOOLEAN isOnPlatform;
     int coin;
 
+    int portalSceneId; // scene of the portal touched since the last TakePortalSceneId, -1 for none
+
     void OnCollisionWithGoomba(LPCOLLISIONEVENT e);
     void OnCollisionWithCoin(LPCOLLISIONEVENT e);
     void OnCollisionWithPortal(LPCOLLISIONEVENT e);
@@ -117,6 +126,8 @@ class CMario : public CGameObject {
 
 public:
     CMario(float x, float y) : CGameObject(x, y) {
+        type = OBJECT_TYPE_MARIO;
+        SetCollisionLayer(COLLISION_LAYER_MARIO, COLLISION_MASK_MARIO);
         isSitting = false;
         maxVx = 0.0f;
         ax = 0.0f;
@@ -124,9 +135,10 @@ public:
 
         level = MARIO_LEVEL_BIG;
         untouchable = 0;
-        untouchable_start = -1;
+        untouchable_time = 0;
         isOnPlatform = false;
         coin = 0;
+        portalSceneId = -1;
     }
     void Update(DWORD dt, vector<LPGAMEOBJECT> *coObjects);
     void Render();
@@ -142,10 +154,29 @@ public:
     void OnCollisionWith(LPCOLLISIONEVENT e);
 
     void SetLevel(int l);
+    int GetLevel() { return level; }
+    int GetCoin() { return coin; }
+
+    // Buttons held this step and on the previous one (MARIO_INPUT_xxx): pressing and releasing
+    // them work the same as the keys of CSampleKeyHandler
+    void SetInput(int input, int previous);
+
+    // The scene decides what touching a portal does, -1 when none was touched
+    int TakePortalSceneId() {
+        int id = portalSceneId;
+        portalSceneId = -1;
+        return id;
+    }
     void StartUntouchable() {
         untouchable = 1;
-        untouchable_start = GetTickCount64();
+        untouchable_time = 0;
     }
 
     void GetBoundingBox(float &left, float &top, float &right, float &bottom);
+
+    void Save(CSaveWriter &w);
+    void Restore(CSaveReader &r);
+
+    // Fill the collision dispatch table with Mario's handlers, once however often it is called
+    static void RegisterCollisionHandlers();
 };
@@ -0,0 +1,85 @@
+#include "GameObject.hpp"
+#include "ObjectSlotMap.hpp"
+
+CObjectHandle CObjectSlotMap::Insert(LPGAMEOBJECT obj) {
+    UINT index = freeHead;
+    if (index == slots.size()) {
+        CSlot slot;
+        slot.generation = 1;
+        slots.push_back(slot);
+        freeHead = (UINT)slots.size();
+    } else
+        freeHead = slots[index].nextFree;
+
+    CSlot &slot = slots[index];
+    slot.dense = (UINT)objects.size();
+    objects.push_back(obj);
+    denseSlots.push_back(index);
+
+    CObjectHandle handle(index, slot.generation);
+    obj->SetSlot(this, handle);
+    return handle;
+}
+
+void CObjectSlotMap::DeferRemove(CObjectHandle handle) {
+    if (IsValid(handle))
+        pending.push_back(handle);
+}
+
+void CObjectSlotMap::FlushRemovals(vector<LPGAMEOBJECT> &removed) {
+    for (size_t i = 0; i < pending.size(); i++) {
+        CObjectHandle handle = pending[i];
+        if (!IsValid(handle))
+            continue; // queued twice
+
+        CSlot &slot = slots[handle.index];
+        UINT dense = slot.dense;
+        removed.push_back(objects[dense]);
+
+        // the last object takes the freed place
+        UINT last = (UINT)objects.size() - 1;
+        objects[dense] = objects[last];
+        denseSlots[dense] = denseSlots[last];
+        slots[denseSlots[dense]].dense = dense;
+        objects.pop_back();
+        denseSlots.pop_back();
+
+        slot.generation++;
+        if (slot.generation == 0)
+            slot.generation = 1;
+        slot.nextFree = freeHead;
+        freeHead = handle.index;
+    }
+
+    pending.clear();
+}
+
+void CObjectSlotMap::TakeChanges(vector<LPGAMEOBJECT> &objects) {
+    for (size_t i = 0; i < changed.size(); i++) {
+        LPGAMEOBJECT obj = Get(changed[i]);
+        if (obj != NULL)
+            objects.push_back(obj);
+    }
+
+    changed.clear();
+}
+
+/*
+    Forget every object, without freeing them. Every handle handed out so far becomes stale
+*/
+void CObjectSlotMap::Clear() {
+    objects.clear();
+    denseSlots.clear();
+    pending.clear();
+    changed.clear();
+
+    // keep the slots so that their generation keeps growing
+    freeHead = (UINT)slots.size();
+    for (size_t i = slots.size(); i-- > 0;) {
+        slots[i].generation++;
+        if (slots[i].generation == 0)
+            slots[i].generation = 1;
+        slots[i].nextFree = freeHead;
+        freeHead = (UINT)i;
+    }
+}
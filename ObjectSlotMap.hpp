@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+class CGameObject;
+typedef CGameObject *LPGAMEOBJECT;
+
+/*
+    Reference to an object of a CObjectSlotMap that can tell when the object is gone: once its slot
+    is recycled the generation no longer matches and the handle resolves to NULL
+*/
+struct CObjectHandle {
+    UINT index;
+    UINT generation; // 0 is never handed out, so a default handle is null
+
+    CObjectHandle() {
+        index = 0;
+        generation = 0;
+    }
+    CObjectHandle(UINT index, UINT generation) {
+        this->index = index;
+        this->generation = generation;
+    }
+
+    bool IsNull() const { return generation == 0; }
+    bool operator==(const CObjectHandle &h) const { return index == h.index && generation == h.generation; }
+    bool operator!=(const CObjectHandle &h) const { return !(*this == h); }
+};
+
+/*
+    Objects of a scene, stored densely and reached through generational handles
+
+    Insert and removal are O(1): removing swaps the last object into the freed place, and freed
+    slots are recycled through a free list with their generation bumped, so handles to removed
+    objects are detected as stale. Removals are deferred: CGameObject::Delete queues the object
+    and FlushRemovals takes all of them out at the end of the frame, so the dense array never
+    changes while systems iterate it. Iteration order is insertion order until the first removal
+*/
+class CObjectSlotMap {
+    struct CSlot {
+        UINT generation;
+        UINT dense;    // index in objects while in use
+        UINT nextFree; // next free slot while free
+    };
+
+    vector<CSlot> slots;
+    UINT freeHead; // first free slot, slots.size() when none
+
+    vector<LPGAMEOBJECT> objects; // dense
+    vector<UINT> denseSlots;      // slot of each dense object
+
+    vector<CObjectHandle> pending; // removals waiting for FlushRemovals
+    vector<CObjectHandle> changed; // see QueueChange
+
+public:
+    CObjectSlotMap() { freeHead = 0; }
+
+    CObjectHandle Insert(LPGAMEOBJECT obj);
+
+    // Queue the object for removal at the next FlushRemovals, stale handles are ignored
+    void DeferRemove(CObjectHandle handle);
+    bool HasPendingRemovals() { return !pending.empty(); }
+
+    // Take the queued objects out and append them to removed, the caller frees them
+    void FlushRemovals(vector<LPGAMEOBJECT> &removed);
+
+    // Remember that the collision setup of an object changed (see CGameObject::SetCollisionLayer),
+    // so that the scene can update its collider lists between frames
+    void QueueChange(CObjectHandle handle) { changed.push_back(handle); }
+
+    // Append the objects queued by QueueChange that are still there, and forget the queue
+    void TakeChanges(vector<LPGAMEOBJECT> &objects);
+
+    // NULL once the object has been removed
+    LPGAMEOBJECT Get(CObjectHandle handle) const {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+            return NULL;
+        return objects[slots[handle.index].dense];
+    }
+    bool IsValid(CObjectHandle handle) const { return Get(handle) != NULL; }
+
+    // Position of the object in the dense view, -1 once it has been removed
+    int GetIndex(CObjectHandle handle) const {
+        if (!IsValid(handle))
+            return -1;
+        return (int)slots[handle.index].dense;
+    }
+
+    void Clear();
+
+    // Dense view, valid until the next Insert or FlushRemovals
+    const vector<LPGAMEOBJECT> &GetObjects() const { return objects; }
+    LPGAMEOBJECT operator[](size_t i) const { return objects[i]; }
+    size_t GetSize() const { return objects.size(); }
+};
+
+typedef CObjectSlotMap *LPOBJECTSLOTMAP;
@@ -13,7 +13,7 @@ void CPlatform::RenderBoundingBox() {
 
     float l, t, r, b;
 
-    GetBoundingBox(l, t, r, b);
+    GetCachedBoundingBox(l, t, r, b);
     rect.left = 0;
     rect.top = 0;
     rect.right = (int)r - (int)l;
@@ -52,3 +52,23 @@ void CPlatform::GetBoundingBox(float &l, float &t, float &r, float &b) {
     r = l + this->cellWidth * this->length;
     b = t + this->cellHeight;
 }
+
+void CPlatform::Save(CSaveWriter &w) {
+    CGameObject::Save(w);
+    w.Write(length);
+    w.Write(cellWidth);
+    w.Write(cellHeight);
+    w.Write(spriteIdBegin);
+    w.Write(spriteIdMiddle);
+    w.Write(spriteIdEnd);
+}
+
+void CPlatform::Restore(CSaveReader &r) {
+    CGameObject::Restore(r);
+    r.Read(length);
+    r.Read(cellWidth);
+    r.Read(cellHeight);
+    r.Read(spriteIdBegin);
+    r.Read(spriteIdMiddle);
+    r.Read(spriteIdEnd);
+}
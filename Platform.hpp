@@ -16,6 +16,8 @@ public:
     CPlatform(float x, float y,
               float cell_width, float cell_height, int length,
               int sprite_id_begin, int sprite_id_middle, int sprite_id_end) : CGameObject(x, y) {
+        this->type = OBJECT_TYPE_PLATFORM;
+        SetCollisionLayer(COLLISION_LAYER_PLATFORM, COLLISION_MASK_PLATFORM);
         this->length = length;
         this->cellWidth = cell_width;
         this->cellHeight = cell_height;
@@ -27,7 +29,11 @@ public:
     void Render();
     void Update(DWORD dt) {}
     void GetBoundingBox(float &l, float &t, float &r, float &b);
+    int IsStatic() { return 1; }
     void RenderBoundingBox();
+
+    void Save(CSaveWriter &w);
+    void Restore(CSaveReader &r);
 };
 
 typedef CPlatform *LPPLATFORM;
@@ -1,4 +1,5 @@
 #include "AssetIDs.hpp"
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 
@@ -14,9 +15,62 @@
 
 using namespace std;
 
-CPlayScene::CPlayScene(int id, LPCWSTR filePath) : CScene(id, filePath) {
-    player = NULL;
+CPlayScene::CPlayScene(int id, LPCWSTR filePath, bool isIsolated) : CScene(id, filePath) {
     key_handler = new CSampleKeyHandler(this);
+    activationMargin = ACTIVATION_MARGIN;
+    isLevelStreaming = PLAYSCENE_LEVEL_STREAMING != 0;
+    prefetchDistance = PLAYSCENE_PREFETCH_DISTANCE;
+    isRewinding = false;
+    camX = camY = 0;
+    prevCamX = prevCamY = 0;
+    this->isIsolated = isIsolated;
+
+    if (isIsolated) {
+        isRewindEnabled = false;
+        viewWidth = viewHeight = 0;
+    } else {
+        CGame *game = CGame::GetInstance();
+        // headless, there is no key to rewind with unless a recording is replayed
+        isRewindEnabled = PLAYSCENE_REWIND != 0 && (!game->IsHeadless() || game->IsReplaying());
+        viewWidth = game->GetBackBufferWidth();
+        viewHeight = game->GetBackBufferHeight();
+    }
+    portalSceneId = -1;
+
+    CMario::RegisterCollisionHandlers();
+
+#if PLAYSCENE_BROADPHASE == BROADPHASE_SWEEP_AND_PRUNE
+    broadphase = new CSweepAndPrune();
+#else
+    broadphase = new CSpatialGrid();
+#endif
+
+    stream.SetScene(&objects, [this](const string &line) { return CreateObject(line); });
+}
+
+/*
+    The scene must have been unloaded: only what the constructor created is freed here
+*/
+CPlayScene::~CPlayScene() {
+    delete broadphase;
+    delete key_handler;
+}
+
+/*
+    Replace the collision broadphase, the current colliable objects are moved to the new one
+*/
+void CPlayScene::SetBroadphase(LPBROADPHASE broadphase) {
+    vector<LPGAMEOBJECT> *coObjects = colliders.GetObjects();
+    for (size_t i = 0; i < coObjects->size(); i++) {
+        if (!coObjects->at(i)->IsStatic())
+            broadphase->Insert(coObjects->at(i));
+    }
+
+    delete this->broadphase;
+    this->broadphase = broadphase;
+
+    if (GetPlayer() != NULL)
+        query.SetSources(broadphase, &staticLayer, GetPlayer());
 }
 
 #define SCENE_SECTION_UNKNOWN -1
@@ -43,7 +97,7 @@ void CPlayScene::_ParseSection_SPRITES(string line) {
     int texID = atoi(tokens[5].c_str());
 
     LPTEXTURE tex = CTextures::GetInstance()->Get(texID);
-    if (tex == NULL) {
+    if (tex == NULL && !CGame::GetInstance()->IsHeadless()) {
         DebugOut(L"[ERROR] Texture ID %d not found!\n", texID);
         return;
     }
@@ -52,6 +106,9 @@ void CPlayScene::_ParseSection_SPRITES(string line) {
 }
 
 void CPlayScene::_ParseSection_ASSETS(string line) {
+    if (isIsolated)
+        return; // never drawn, and the sprites and animations are the game's
+
     vector<string> tokens = split(line);
 
     if (tokens.size() < 1)
@@ -84,15 +141,65 @@ void CPlayScene::_ParseSection_ANIMATIONS(string line) {
 }
 
 /*
-    Parse a line in section [OBJECTS]
+    Parse a line in section [OBJECTS]. The player is created right away, the other objects are
+    handed to the level stream and created once the camera gets near their chunk
 */
 void CPlayScene::_ParseSection_OBJECTS(string line) {
     vector<string> tokens = split(line);
 
     // skip invalid lines - an object set must have at least id, x, y
-    if (tokens.size() < 2)
+    if (tokens.size() < 3)
         return;
 
+    int object_type = atoi(tokens[0].c_str());
+    float x = (float)atof(tokens[1].c_str());
+
+    if (object_type == OBJECT_TYPE_MARIO) {
+        LPGAMEOBJECT player = CreateObject(line);
+        if (player != NULL)
+            AddObject(player);
+        return;
+    }
+
+    // how far right the object reaches, so that wide ones load with the chunks they cover
+    float r = x;
+    if (object_type == OBJECT_TYPE_PLATFORM && tokens.size() >= 6)
+        r = x + (float)atof(tokens[3].c_str()) * atoi(tokens[5].c_str());
+    else if (object_type == OBJECT_TYPE_PORTAL && tokens.size() >= 4)
+        r = (float)atof(tokens[3].c_str());
+
+    stream.Add(line, x, max(x, r));
+}
+
+/*
+    Object of a type with default settings, RestoreState then reads its actual state into it
+*/
+LPGAMEOBJECT CPlayScene::NewObject(int type) {
+    switch (type) {
+    case OBJECT_TYPE_MARIO:
+        return new CMario(0, 0);
+    case OBJECT_TYPE_GOOMBA:
+        return new CGoomba(0, 0);
+    case OBJECT_TYPE_BRICK:
+        return new CBrick(0, 0);
+    case OBJECT_TYPE_COIN:
+        return new CCoin(0, 0);
+    case OBJECT_TYPE_PLATFORM:
+        return new CPlatform(0, 0, 0, 0, 0, 0, 0, 0);
+    case OBJECT_TYPE_PORTAL:
+        return new CPortal(0, 0, 0, 0, 0);
+    }
+
+    DebugOut(L"[ERROR] Invalid object type: %d\n", type);
+    return NULL;
+}
+
+/*
+    Create the object of an [OBJECTS] line and insert it into objects, NULL for an invalid line
+*/
+LPGAMEOBJECT CPlayScene::CreateObject(const string &line) {
+    vector<string> tokens = split(line);
+
     int object_type = atoi(tokens[0].c_str());
     float x = (float)atof(tokens[1].c_str());
     float y = (float)atof(tokens[2].c_str());
@@ -101,12 +208,11 @@ void CPlayScene::_ParseSection_OBJECTS(string line) {
 
     switch (object_type) {
     case OBJECT_TYPE_MARIO:
-        if (player != NULL) {
+        if (GetPlayer() != NULL) {
             DebugOut(L"[ERROR] MARIO object was created before!\n");
-            return;
+            return NULL;
         }
         obj = new CMario(x, y);
-        player = (CMario *)obj;
 
         DebugOut(L"[INFO] Player object has been created!\n");
         break;
@@ -146,25 +252,40 @@ void CPlayScene::_ParseSection_OBJECTS(string line) {
 
     default:
         DebugOut(L"[ERROR] Invalid object type: %d\n", object_type);
-        return;
+        return NULL;
     }
 
     // General object setup
     obj->SetPosition(x, y);
 
-    objects.push_back(obj);
+    CObjectHandle handle = objects.Insert(obj);
+    if (object_type == OBJECT_TYPE_MARIO)
+        playerHandle = handle;
+
+    return obj;
+}
+
+/*
+    Register a new object with the scene. It starts awake, UpdateActivation puts it to sleep if
+    it is far from the camera
+*/
+void CPlayScene::AddObject(LPGAMEOBJECT obj) {
+    if (obj->IsStatic() && obj != GetPlayer())
+        staticLayer.Add(obj);
+    active.push_back(obj);
+    SetCollider(obj, IsCollider(obj));
 }
 
 void CPlayScene::LoadAssets(LPCWSTR assetFile) {
     DebugOut(L"[INFO] Start loading assets from : %s \n", assetFile);
 
     ifstream f;
-    f.open(assetFile);
+    OpenFile(f, assetFile);
 
     int section = ASSETS_SECTION_UNKNOWN;
 
     char str[MAX_SCENE_LINE];
-    while (f.getline(str, MAX_SCENE_LINE)) {
+    while (f.getline(str, MAX_SCENE_LINE) && !isLoadCancelled) {
         string line(str);
 
         if (line[0] == '#')
@@ -204,14 +325,17 @@ void CPlayScene::LoadAssets(LPCWSTR assetFile) {
 void CPlayScene::Load() {
     DebugOut(L"[INFO] Start loading scene from : %s \n", sceneFilePath);
 
+    LPSCENEARENA previousArena = CSceneArena::GetCurrent();
+    CSceneArena::SetCurrent(&arena);
+
     ifstream f;
-    f.open(sceneFilePath);
+    OpenFile(f, sceneFilePath);
 
     // current resource section flag
     int section = SCENE_SECTION_UNKNOWN;
 
     char str[MAX_SCENE_LINE];
-    while (f.getline(str, MAX_SCENE_LINE)) {
+    while (f.getline(str, MAX_SCENE_LINE) && !isLoadCancelled) {
         string line(str);
 
         if (line[0] == '#')
@@ -244,56 +368,304 @@ void CPlayScene::Load() {
 
     f.close();
 
+    if (isLoadCancelled) {
+        CSceneArena::SetCurrent(previousArena);
+        DebugOut(L"[INFO] Loading scene %s cancelled\n", sceneFilePath);
+        return;
+    }
+
+    // the chunks around the player are there from the first frame, whatever the step limit
+    spawned.clear();
+    float cx, cy;
+    if (isLevelStreaming && GetCameraTarget(cx, cy))
+        stream.Update(cx, cx + viewWidth, SIZE_MAX, spawned);
+    else
+        stream.LoadAll(spawned);
+
+    for (size_t i = 0; i < spawned.size(); i++)
+        AddObject(spawned[i]);
+
+    // not logged by Build itself, which also runs whenever streaming changes the layer
+    staticLayer.Build();
+    int columns, rows;
+    staticLayer.GetTileCount(columns, rows);
+    DebugOut(L"[INFO] Static layer built: %d boxes, %d x %d tiles\n", (int)staticLayer.GetSize(), columns, rows);
+    query.SetSources(broadphase, &staticLayer, GetPlayer());
+
+    CSceneArena::SetCurrent(previousArena);
+
+    SaveState(initialState);
+
+    DebugOut(L"[INFO] Level: %d chunks, %d objects loaded\n",
+             (int)stream.GetChunkCount(), (int)stream.GetResidentCount());
+
     DebugOut(L"[INFO] Done loading scene  %s\n", sceneFilePath);
 }
 
+/*
+    Put to sleep the objects that left the region around the camera and wake up the sleeping
+    objects the camera is approaching. Static objects still collide while asleep (they stay in
+    the static layer), they are only no longer rendered
+*/
+void CPlayScene::UpdateActivation() {
+    float l = camX - activationMargin;
+    float t = camY - activationMargin;
+    float r = camX + viewWidth + activationMargin;
+    float b = camY + viewHeight + activationMargin;
+
+    bool changed = false;
+    LPGAMEOBJECT player = GetPlayer();
+
+    for (size_t i = 0; i < active.size(); i++) {
+        LPGAMEOBJECT obj = active[i];
+        if (obj == player || obj->IsDeleted())
+            continue;
+        if (CActivationRegion::IsInside(obj,
+                                        l - ACTIVATION_HYSTERESIS, t - ACTIVATION_HYSTERESIS,
+                                        r + ACTIVATION_HYSTERESIS, b + ACTIVATION_HYSTERESIS))
+            continue;
+
+        obj->SetActive(false);
+        activation.Sleep(obj);
+        SetCollider(obj, false);
+        changed = true;
+    }
+
+    woken.clear();
+    activation.Wake(l, t, r, b, woken);
+    for (size_t i = 0; i < woken.size(); i++) {
+        woken[i]->SetActive(true);
+        SetCollider(woken[i], IsCollider(woken[i]));
+        changed = true;
+    }
+
+    // keep the update order of awake objects the same as in objects, whatever the wake order
+    if (changed) {
+        active.clear();
+        for (size_t i = 0; i < objects.GetSize(); i++)
+            if (objects[i]->IsActive())
+                active.push_back(objects[i]);
+    }
+}
+
+/*
+    Objects are colliders while they can be hit: the player is handled by its own Update only,
+    dead objects leave their collision layer (see CGoomba::SetState)
+*/
+bool CPlayScene::IsCollider(LPGAMEOBJECT obj) {
+    return obj != GetPlayer() && obj->IsActive() && !obj->IsDeleted() &&
+           obj->GetCollisionLayer() != COLLISION_LAYER_NONE;
+}
+
+void CPlayScene::SetCollider(LPGAMEOBJECT obj, bool collider) {
+    if (collider == colliders.Contains(obj))
+        return;
+
+    if (collider) {
+        colliders.Add(obj);
+        if (!obj->IsStatic())
+            broadphase->Insert(obj);
+    } else {
+        colliders.Remove(obj);
+        if (!obj->IsStatic())
+            broadphase->Remove(obj);
+    }
+}
+
+/*
+    Apply the collision layer changes made during the last frame, so the collider list stays the
+    same for the whole frame
+*/
+void CPlayScene::UpdateColliders() {
+    changed.clear();
+    objects.TakeChanges(changed);
+    for (size_t i = 0; i < changed.size(); i++)
+        SetCollider(changed[i], IsCollider(changed[i]));
+}
+
 void CPlayScene::Update(DWORD dt) {
-    // We know that Mario is the first object in the list hence we won't add him into the colliable object list
-    // TO-DO: This is a "dirty" way, need a more organized way
+    if (isRewinding) {
+        prevCamX = camX;
+        prevCamY = camY;
+        rewind.Rewind(this); // stays on the oldest frame once there is nothing older
+        return;
+    }
+
+    UpdateActivation();
+    UpdateColliders();
+
+    prevCamX = camX;
+    prevCamY = camY;
+    for (size_t i = 0; i < active.size(); i++)
+        active[i]->SavePosition();
+
+    vector<LPGAMEOBJECT> *coObjects = colliders.GetObjects();
 
-    vector<LPGAMEOBJECT> coObjects;
-    for (size_t i = 1; i < objects.size(); i++) {
-        coObjects.push_back(objects[i]);
+    // Track colliable objects by their movement over this frame, then keep the broadphase in sync
+    // as each object moves so that later objects in the loop see up-to-date boxes
+    for (size_t i = 0; i < coObjects->size(); i++) {
+        if (!coObjects->at(i)->IsStatic())
+            broadphase->Update(coObjects->at(i), dt);
     }
 
-    for (size_t i = 0; i < objects.size(); i++) {
-        objects[i]->Update(dt, &coObjects);
+    CCollision *collision = CCollision::GetInstance();
+    collision->SetBroadphase(broadphase);
+    collision->SetStaticLayer(&staticLayer);
+    collision->ResetPairStats(); // pair counters cover one frame
+
+    for (size_t i = 0; i < active.size(); i++) {
+        active[i]->Update(dt, coObjects);
+        broadphase->Update(active[i], dt);
     }
 
+    collision->SetBroadphase(NULL);
+    collision->SetStaticLayer(NULL);
+    collision->ResetEvents(); // collision events are frame-scoped
+
     // skip the rest if scene was already unloaded (Mario::Update might trigger PlayScene::Unload)
-    if (player == NULL)
+    if (GetPlayer() == NULL)
         return;
 
-    // Update camera to follow mario
-    float cx, cy;
+    portalSceneId = ((CMario *)GetPlayer())->TakePortalSceneId();
+    if (portalSceneId >= 0 && !isIsolated)
+        CGame::GetInstance()->InitiateSwitchScene(portalSceneId);
+
+    FollowPlayer();
+    UpdateStreaming();
+    UpdatePrefetch();
+
+    PurgeDeletedObjects();
+    if (staticLayer.IsDirty())
+        staticLayer.Build();
+
+    if (isRewindEnabled)
+        rewind.Capture(this);
+}
+
+/*
+    Camera position following mario, false without a player
+*/
+bool CPlayScene::GetCameraTarget(float &cx, float &cy) {
+    LPGAMEOBJECT player = GetPlayer();
+    if (player == NULL)
+        return false;
+
     player->GetPosition(cx, cy);
 
-    CGame *game = CGame::GetInstance();
-    cx -= game->GetBackBufferWidth() / 2;
-    cy -= game->GetBackBufferHeight() / 2;
+    cx -= viewWidth / 2;
+    cy -= viewHeight / 2;
 
     if (cx < 0)
         cx = 0;
+    cy = 0.0f; // the camera only scrolls horizontally
 
-    CGame::GetInstance()->SetCamPos(cx, 0.0f /*cy*/);
+    return true;
+}
 
-    PurgeDeletedObjects();
+/*
+    Update camera to follow mario
+*/
+void CPlayScene::FollowPlayer() {
+    GetCameraTarget(camX, camY);
 }
 
+/*
+    Prefetch the scene of the nearest portal within prefetchDistance of the player, and give up
+    the prefetch once the player walked away from every portal. Sleeping portals are not seen,
+    so the distance should stay within the activation region
+*/
+void CPlayScene::UpdatePrefetch() {
+    if (prefetchDistance <= 0 || isIsolated)
+        return;
+
+    LPGAMEOBJECT player = GetPlayer();
+    float l, t, r, b;
+    player->GetCachedBoundingBox(l, t, r, b);
+
+    portals.clear();
+    query.Overlap(l - prefetchDistance, t - prefetchDistance, r + prefetchDistance, b + prefetchDistance,
+                  portals, COLLISION_LAYER_TRIGGER, player);
+
+    float px = (l + r) / 2, py = (t + b) / 2;
+    CPortal *nearest = NULL;
+    float nearestDistance = 0;
+    for (size_t i = 0; i < portals.size(); i++) {
+        if (portals[i]->GetType() != OBJECT_TYPE_PORTAL)
+            continue;
+
+        float pl, pt, pr, pb;
+        portals[i]->GetCachedBoundingBox(pl, pt, pr, pb);
+        float dx = (pl + pr) / 2 - px, dy = (pt + pb) / 2 - py;
+        float distance = dx * dx + dy * dy;
+        if (nearest == NULL || distance < nearestDistance) {
+            nearest = (CPortal *)portals[i];
+            nearestDistance = distance;
+        }
+    }
+
+    CGame *game = CGame::GetInstance();
+    if (nearest != NULL)
+        game->PrefetchScene(nearest->GetSceneId());
+    else
+        game->CancelPrefetch();
+}
+
+/*
+    The scene may have been loaded in the background, the camera is only placed now
+*/
+void CPlayScene::Enter() {
+    FollowPlayer();
+}
+
+/*
+    Create the objects of the chunks the camera is heading to and evict the chunks left behind,
+    a few objects per frame. Evicted objects are Delete()d, so they go with this frame's purge
+*/
+void CPlayScene::UpdateStreaming() {
+    if (!isLevelStreaming)
+        return;
+
+    LPSCENEARENA previousArena = CSceneArena::GetCurrent();
+    CSceneArena::SetCurrent(&arena);
+
+    spawned.clear();
+    stream.Update(camX, camX + viewWidth, LEVEL_STREAM_STEPS_PER_FRAME, spawned);
+    for (size_t i = 0; i < spawned.size(); i++)
+        AddObject(spawned[i]);
+
+    CSceneArena::SetCurrent(previousArena);
+}
+
+/*
+    Draw the scene in between the last two updates, see CGame::GetRenderAlpha
+*/
 void CPlayScene::Render() {
-    for (int i = 0; i < objects.size(); i++)
-        objects[i]->Render();
+    CGame *game = CGame::GetInstance();
+    float alpha = game->GetRenderAlpha();
+
+    game->SetCamPos(prevCamX + (camX - prevCamX) * alpha, prevCamY + (camY - prevCamY) * alpha);
+
+    for (int i = 0; i < active.size(); i++) {
+        active[i]->BeginRender(alpha);
+        active[i]->Render();
+        active[i]->EndRender();
+    }
 }
 
 /*
  *	Clear all objects from this scene
  */
 void CPlayScene::Clear() {
-    vector<LPGAMEOBJECT>::iterator it;
-    for (it = objects.begin(); it != objects.end(); it++) {
-        delete (*it);
-    }
-    objects.clear();
+    for (size_t i = 0; i < objects.GetSize(); i++)
+        delete objects[i];
+    objects.Clear();
+    active.clear();
+    colliders.Clear();
+    broadphase->Clear();
+    staticLayer.Clear();
+    activation.Clear();
+    stream.Clear();
+    query.SetSources(NULL, NULL, NULL);
 }
 
 /*
@@ -303,30 +675,330 @@ void CPlayScene::Clear() {
 
 */
 void CPlayScene::Unload() {
-    for (int i = 0; i < objects.size(); i++)
+    for (size_t i = 0; i < objects.GetSize(); i++)
         delete objects[i];
 
-    objects.clear();
-    player = NULL;
+    objects.Clear();
+    active.clear();
+    colliders.Clear();
+    broadphase->Clear();
+    staticLayer.Clear();
+    activation.Clear();
+    stream.Clear();
+    query.SetSources(NULL, NULL, NULL);
+    playerHandle = CObjectHandle();
+    initialState.clear();
+    hashState.clear();
+    savedIndices.clear();
+
+    if (rewind.GetCaptureCount() > 0)
+        DebugOut(L"[INFO] Rewind: %d frames captured (%d keyframes), %.3f ms average, %.3f ms max, %d over "
+                 L"budget, %.0f bytes per frame (deltas %.0f), %d KB held\n",
+                 (int)rewind.GetCaptureCount(), (int)rewind.GetKeyframeCount(), rewind.GetAverageCaptureNs() / 1e6,
+                 rewind.GetMaxCaptureNs() / 1e6, (int)rewind.GetOverBudgetCount(), rewind.GetAverageFrameBytes(),
+                 rewind.GetAverageDeltaBytes(), (int)(rewind.GetMemory() / 1024));
+    rewind.Clear();
+    rewind.ResetStats();
+    isRewinding = false;
+
+    // animations were loaded with the scene, they have to go before its arena
+    if (!isIsolated)
+        CAnimations::GetInstance()->Clear();
+
+    DebugOut(L"[INFO] Scene arena: %d allocations (%d reused), %d heap blocks, %d KB\n",
+             (int)arena.GetAllocationCount(), (int)arena.GetReuseCount(),
+             (int)arena.GetHeapAllocationCount(), (int)(arena.GetCapacity() / 1024));
+    arena.Reset();
 
     DebugOut(L"[INFO] Scene %d unloaded! \n", id);
 }
 
-bool CPlayScene::IsGameObjectDeleted(const LPGAMEOBJECT &o) { return o == NULL; }
-
+/*
+    Free the objects deleted during the frame. Nothing to do on most frames. Otherwise the slot
+    map knows which objects to take out, the grounds that pointed at them read as NULL from then
+    on (see CGameObject::GetGround), and active is compacted in one pass, which keeps the update
+    order of the awake objects. Sleeping objects are never visited
+*/
 void CPlayScene::PurgeDeletedObjects() {
-    vector<LPGAMEOBJECT>::iterator it;
-    for (it = objects.begin(); it != objects.end(); it++) {
-        LPGAMEOBJECT o = *it;
-        if (o->IsDeleted()) {
-            delete o;
-            *it = NULL;
+    if (!objects.HasPendingRemovals())
+        return;
+
+    active.erase(
+        std::remove_if(active.begin(), active.end(), [](LPGAMEOBJECT o) { return o->IsDeleted(); }),
+        active.end());
+
+    removed.clear();
+    objects.FlushRemovals(removed);
+
+    for (size_t i = 0; i < removed.size(); i++) {
+        LPGAMEOBJECT o = removed[i];
+        if (!o->IsActive())
+            activation.Remove(o);
+        SetCollider(o, false);
+        staticLayer.Remove(o);
+        delete o;
+    }
+}
+
+/*
+    Layout: magic, version, size of the whole blob, object and level record counts, index of the
+    player, the type of each object, then each object (size of its own Save, its own Save, index of
+    its ground) and the level stream. Objects are written in the order of objects, and refer to each
+    other by their index in it
+*/
+void CPlayScene::SaveState(vector<BYTE> &data) {
+    PurgeDeletedObjects(); // so that restoring does not bring back what was about to go
+    WriteState(data);
+}
+
+/*
+    Only the objects not deleted are written, so their indices in the save state skip the deleted
+    ones: savedIndices maps the index of each object in objects to it. Once purged, both are the same
+*/
+void CPlayScene::WriteState(vector<BYTE> &data) {
+    savedIndices.resize(objects.GetSize());
+    UINT count = 0;
+    for (size_t i = 0; i < objects.GetSize(); i++)
+        savedIndices[i] = objects[i]->IsDeleted() ? -1 : (int)count++;
+
+    CSaveWriter w(data);
+
+    w.Write((UINT)SAVE_STATE_MAGIC);
+    w.Write((UINT)SAVE_STATE_VERSION);
+    w.Write((UINT)0); // size, once known
+    w.Write(count);
+    w.Write((UINT)stream.GetRecordCount());
+    w.Write(GetSavedIndex(GetPlayer()));
+
+    for (size_t i = 0; i < objects.GetSize(); i++)
+        if (savedIndices[i] >= 0)
+            w.Write((BYTE)objects[i]->GetType());
+
+    for (size_t i = 0; i < objects.GetSize(); i++) {
+        if (savedIndices[i] < 0)
+            continue;
+
+        LPGAMEOBJECT obj = objects[i];
+        size_t position = w.GetSize();
+        w.Write((UINT)0); // size, once known
+        obj->Save(w);
+        w.Patch(position, (UINT)(w.GetSize() - position - sizeof(UINT)));
+        w.Write(GetSavedIndex(obj->GetGround()));
+    }
+
+    stream.Save(w, savedIndices);
+
+    w.Patch(2 * sizeof(UINT), (UINT)w.GetSize());
+    w.Close();
+}
+
+// -1 for NULL and for objects that are not saved
+int CPlayScene::GetSavedIndex(LPGAMEOBJECT obj) {
+    int index = obj != NULL ? objects.GetIndex(obj->GetHandle()) : -1;
+    return index >= 0 ? savedIndices[index] : -1;
+}
+
+UINT64 CPlayScene::GetStateHash() {
+    WriteState(hashState);
+
+    UINT64 hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < hashState.size(); i++) {
+        hash ^= hashState[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+    Read the whole of data without touching the scene: header, types that NewObject knows, a player
+    that is a Mario, object records within the blob, grounds among the objects and the level
+    stream. Leaves the type of each object in types
+*/
+bool CPlayScene::CheckState(const vector<BYTE> &data) {
+    CSaveReader r(data);
+    if (r.Read<UINT>() != SAVE_STATE_MAGIC || r.Read<UINT>() != SAVE_STATE_VERSION ||
+        r.Read<UINT>() != data.size()) {
+        DebugOut(L"[ERROR] Not a save state of version %d\n", SAVE_STATE_VERSION);
+        return false;
+    }
+
+    UINT count = r.Read<UINT>();
+    if (r.Read<UINT>() != stream.GetRecordCount()) {
+        DebugOut(L"[ERROR] Save state of another level\n");
+        return false;
+    }
+    int playerIndex = r.Read<int>();
+
+    // each object takes at least its size and ground index, which also bounds types.resize
+    bool isValid = r.IsValid() && count <= (data.size() - r.GetPosition()) / (1 + 2 * sizeof(UINT));
+    types.resize(isValid ? count : 0);
+    for (UINT i = 0; i < types.size() && isValid; i++) {
+        r.Read(types[i]);
+        switch (types[i]) {
+        case OBJECT_TYPE_MARIO:
+        case OBJECT_TYPE_GOOMBA:
+        case OBJECT_TYPE_BRICK:
+        case OBJECT_TYPE_COIN:
+        case OBJECT_TYPE_PLATFORM:
+        case OBJECT_TYPE_PORTAL:
+            break;
+        default:
+            isValid = false;
+        }
+    }
+
+    isValid = isValid && playerIndex >= -1 && playerIndex < (int)count &&
+              (playerIndex < 0 || types[playerIndex] == OBJECT_TYPE_MARIO);
+
+    for (UINT i = 0; i < count && isValid; i++) {
+        r.Skip(r.Read<UINT>());
+        int ground = r.Read<int>();
+        isValid = ground >= -1 && ground < (int)count;
+    }
+
+    isValid = isValid && r.IsValid() && stream.Check(r, count) && r.IsAtEnd();
+    if (!isValid)
+        DebugOut(L"[ERROR] Save state is corrupted\n");
+    return isValid;
+}
+
+/*
+    Nothing is changed before the whole save state has passed CheckState.
+
+    When the scene holds the same objects as the save state (same count, same types in the same
+    order, as for a reset or a rewind with nothing spawned or purged since) they are restored in
+    place, and only those whose collider or sleeping status changed are registered again.
+    Otherwise every object is freed and created again. The camera follows the restored player at
+    once
+*/
+bool CPlayScene::RestoreState(const vector<BYTE> &data) {
+    if (!CheckState(data))
+        return false;
+
+    CSaveReader r(data);
+    r.Skip(5 * sizeof(UINT)); // header and counts, checked
+    int playerIndex = r.Read<int>();
+    r.Skip(types.size());
+
+    PurgeDeletedObjects();
+
+    bool isSameObjects = types.size() == objects.GetSize();
+    for (size_t i = 0; i < types.size() && isSameObjects; i++)
+        isSameObjects = objects[i]->GetType() == types[i];
+
+    if (isSameObjects) {
+        restored.clear();
+        for (size_t i = 0; i < types.size(); i++)
+            restored.push_back(objects[i]);
+        RestoreObjects(r);
+    } else
+        RebuildObjects(r);
+
+    playerHandle = playerIndex >= 0 ? restored[playerIndex]->GetHandle() : CObjectHandle();
+    query.SetSources(broadphase, &staticLayer, GetPlayer());
+
+    stream.Restore(r, restored);
+
+    FollowPlayer();
+    prevCamX = camX;
+    prevCamY = camY;
+
+    return true;
+}
+
+/*
+    Restore the objects of the scene over themselves. Statics never move, so the static layer
+    stays as it is; the colliders that moved are moved in the broadphase
+*/
+void CPlayScene::RestoreObjects(CSaveReader &r) {
+    bool isActiveChanged = false;
+
+    for (size_t i = 0; i < restored.size(); i++) {
+        LPGAMEOBJECT obj = restored[i];
+        bool wasActive = obj->IsActive();
+        int layer = obj->GetCollisionLayer();
+        float l, t, right, b;
+        obj->GetCachedBoundingBox(l, t, right, b);
+
+        r.Read<UINT>(); // size, checked
+        obj->Restore(r);
+
+        int ground = r.Read<int>();
+        obj->SetGround(ground >= 0 ? restored[ground] : NULL);
+
+        bool isActive = obj->IsActive();
+        if (!wasActive) {
+            // asleep in the column of its box at the time, which may not be the one of its box now
+            float nl, nt, nr, nb;
+            obj->GetCachedBoundingBox(nl, nt, nr, nb);
+            if (isActive || nl != l) {
+                activation.Remove(obj, l);
+                if (!isActive)
+                    activation.Sleep(obj);
+            }
+        } else if (!isActive)
+            activation.Sleep(obj);
+
+        if (isActive != wasActive || obj->GetCollisionLayer() != layer) {
+            isActiveChanged = isActiveChanged || isActive != wasActive;
+            SetCollider(obj, false); // inserted again with its restored layer
+            SetCollider(obj, IsCollider(obj));
+        } else if (isActive && !obj->IsStatic() && colliders.Contains(obj))
+            broadphase->Update(obj, 0);
+    }
+
+    if (isActiveChanged) {
+        active.clear();
+        for (size_t i = 0; i < restored.size(); i++)
+            if (restored[i]->IsActive())
+                active.push_back(restored[i]);
+    }
+}
+
+/*
+    Free every object and create them again from the save state, registered with the scene the
+    same way Load does
+*/
+void CPlayScene::RebuildObjects(CSaveReader &r) {
+    for (size_t i = 0; i < objects.GetSize(); i++)
+        delete objects[i];
+    objects.Clear();
+    active.clear();
+    colliders.Clear();
+    broadphase->Clear();
+    staticLayer.Clear();
+    activation.Clear();
+
+    LPSCENEARENA previousArena = CSceneArena::GetCurrent();
+    CSceneArena::SetCurrent(&arena);
+
+    restored.clear();
+    for (size_t i = 0; i < types.size(); i++) {
+        LPGAMEOBJECT obj = NewObject(types[i]);
+        objects.Insert(obj);
+        restored.push_back(obj);
+    }
+
+    CSceneArena::SetCurrent(previousArena);
+
+    // all created first, so that grounds can refer to objects further on
+    for (size_t i = 0; i < restored.size(); i++) {
+        LPGAMEOBJECT obj = restored[i];
+        r.Read<UINT>(); // size, checked
+        obj->Restore(r);
+
+        int ground = r.Read<int>();
+        if (ground >= 0)
+            obj->SetGround(restored[ground]);
+
+        if (obj->IsActive())
+            AddObject(obj);
+        else {
+            if (obj->IsStatic())
+                staticLayer.Add(obj);
+            activation.Sleep(obj);
         }
     }
 
-    // NOTE: remove_if will swap all deleted items to the end of the vector
-    // then simply trim the vector, this is much more efficient than deleting individual items
-    objects.erase(
-        std::remove_if(objects.begin(), objects.end(), CPlayScene::IsGameObjectDeleted),
-        objects.end());
+    staticLayer.Build();
 }
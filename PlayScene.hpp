@@ -1,18 +1,120 @@
 #pragma once
+#include "ActivationRegion.hpp"
 #include "Brick.hpp"
+#include "ColliderSet.hpp"
 #include "Game.hpp"
 #include "GameObject.hpp"
 #include "Goomba.hpp"
+#include "LevelStream.hpp"
 #include "Mario.hpp"
+#include "ObjectSlotMap.hpp"
+#include "RewindBuffer.hpp"
 #include "Scene.hpp"
+#include "SceneArena.hpp"
+#include "SpatialGrid.hpp"
+#include "SpatialQuery.hpp"
+#include "StaticLayer.hpp"
+#include "SweepAndPrune.hpp"
 #include "Textures.hpp"
 
+#define BROADPHASE_SPATIAL_GRID 1
+#define BROADPHASE_SWEEP_AND_PRUNE 2
+
+// Broadphase used by new play scenes, see CBroadphase
+#define PLAYSCENE_BROADPHASE BROADPHASE_SPATIAL_GRID
+
+// 1 = create the objects of the level chunk by chunk around the camera, see CLevelStream
+#define PLAYSCENE_LEVEL_STREAMING 1
+
+// Distance (in pixels) from a portal at which its scene starts loading in the background, 0 = never
+#define PLAYSCENE_PREFETCH_DISTANCE 128.0f
+
+// 1 = every play scene captures every frame for rewinding, see CRewindBuffer. A capture is a whole
+// save state and the delta, and SaveState purges deleted objects, so it costs every step; with 0
+// only the scenes marked rewind in the game file capture
+#define PLAYSCENE_REWIND 0
+
 class CPlayScene : public CScene {
 protected:
     // A play scene has to have player, right?
-    LPGAMEOBJECT player;
+    CObjectHandle playerHandle;
+
+    // Deleted objects stay in objects until PurgeDeletedObjects, at the end of the frame
+    CObjectSlotMap objects;
+    vector<LPGAMEOBJECT> removed;
+
+    // Memory of the objects and animations created by Load, dropped at once by Unload
+    CSceneArena arena;
+
+    // Objects the others collide with: awake, alive, on a collision layer and not the player.
+    // Kept up to date as objects sleep, wake, die or get deleted, and given to Update as coObjects
+    CColliderSet colliders;
+    vector<LPGAMEOBJECT> changed;
+
+    bool IsCollider(LPGAMEOBJECT obj);
+    void SetCollider(LPGAMEOBJECT obj, bool collider);
+    void UpdateColliders();
+
+    // Collision broadphase over the moving colliders
+    // Static objects (bricks, platforms) go to the static layer, even while asleep
+    LPBROADPHASE broadphase;
+    CStaticLayer staticLayer;
+
+    CSpatialQuery query; // over broadphase, staticLayer and player, once the scene is loaded
+
+    // Objects far from the camera sleep in the activation region, the others are in active
+    // (in the same order as objects). The player never sleeps
+    vector<LPGAMEOBJECT> active;
+    CActivationRegion activation;
+    float activationMargin;
+    vector<LPGAMEOBJECT> woken;
+
+    void UpdateActivation();
+
+    // Objects of the level besides the player, created and evicted as the camera moves
+    CLevelStream stream;
+    bool isLevelStreaming;
+    vector<LPGAMEOBJECT> spawned;
+
+    void UpdateStreaming();
+
+    float prefetchDistance;
+    vector<LPGAMEOBJECT> portals;
+
+    void UpdatePrefetch();
+
+    // The camera of the scene, CGame's is only set for rendering. Objects are woken and streamed
+    // in around the view, of viewWidth x viewHeight
+    float camX, camY;
+    float prevCamX, prevCamY; // camera before the last Update, rendering interpolates from there
+    int viewWidth, viewHeight;
+
+    // Not the game's scene, chosen at construction: portals do not switch scenes and nothing is
+    // prefetched, and no asset is loaded since it is never drawn. Then nothing shared with other
+    // scenes is touched, so isolated scenes can be updated on several threads at once (see
+    // CPlaySceneBatch)
+    bool isIsolated;
+    int portalSceneId;
 
-    vector<LPGAMEOBJECT> objects;
+    // State right after Load, see Reset
+    vector<BYTE> initialState;
+    vector<BYTE> hashState; // scratch, see GetStateHash
+    vector<int> savedIndices; // scratch, see WriteState
+    vector<BYTE> types;
+    vector<LPGAMEOBJECT> restored;
+
+    CRewindBuffer rewind;
+    bool isRewindEnabled;
+    bool isRewinding;
+
+    LPGAMEOBJECT NewObject(int type);
+    bool CheckState(const vector<BYTE> &data);
+    void RestoreObjects(CSaveReader &r);
+    void RebuildObjects(CSaveReader &r);
+    LPGAMEOBJECT CreateObject(const string &line);
+    void AddObject(LPGAMEOBJECT obj);
+    bool GetCameraTarget(float &cx, float &cy);
+    void FollowPlayer();
 
     void _ParseSection_SPRITES(string line);
     void _ParseSection_ANIMATIONS(string line);
@@ -22,20 +124,75 @@ protected:
 
     void LoadAssets(LPCWSTR assetFile);
 
+    // SaveState without purging first: deleted objects are left out, the scene is not changed
+    void WriteState(vector<BYTE> &data);
+    int GetSavedIndex(LPGAMEOBJECT obj);
+
 public:
-    CPlayScene(int id, LPCWSTR filePath);
+    // An isolated scene (see isIsolated) reads nothing from CGame: its view size is 0 x 0 until
+    // SetViewSize, and rewind is off until SetRewindEnabled
+    CPlayScene(int id, LPCWSTR filePath, bool isIsolated = false);
+    ~CPlayScene();
 
     virtual void Load();
+    virtual void Enter();
     virtual void Update(DWORD dt);
     virtual void Render();
     virtual void Unload();
 
-    LPGAMEOBJECT GetPlayer() { return player; }
+    // NULL once the scene has been unloaded
+    LPGAMEOBJECT GetPlayer() { return objects.Get(playerHandle); }
+
+    void SetBroadphase(LPBROADPHASE broadphase);
+    LPBROADPHASE GetBroadphase() { return broadphase; }
+
+    // Region, point, ray and swept box queries against the objects of the scene
+    LPSPATIALQUERY GetSpatialQuery() { return &query; }
+
+    void SetActivationMargin(float margin) { activationMargin = margin; }
+
+    // Without streaming the whole level is created by Load, so set it before loading
+    void SetLevelStreaming(bool streaming) { isLevelStreaming = streaming; }
+    LPLEVELSTREAM GetLevelStream() { return &stream; }
+
+    void SetPrefetchDistance(float distance) { prefetchDistance = distance; }
+
+    void SetViewSize(int width, int height) {
+        viewWidth = width;
+        viewHeight = height;
+    }
+
+    void GetCamPos(float &x, float &y) {
+        x = camX;
+        y = camY;
+    }
+
+    // Scene of the portal the player touched during the last Update, -1 for none
+    int GetPortalSceneId() { return portalSceneId; }
+
+    // Write the whole running scene (objects, player, streamed level) into data, replacing its content
+    void SaveState(vector<BYTE> &data);
+
+    // Put the scene back as it was when data was saved. False, with the scene unchanged, when data
+    // is not a save state of this version and level
+    bool RestoreState(const vector<BYTE> &data);
+
+    // Back to how the scene was right after Load
+    void Reset() { RestoreState(initialState); }
+
+    // FNV-1a of the save state: equal for scenes in the same state, so a replay can check that it
+    // follows its recording (see CInputRecording). Deleted objects are not purged, they are skipped
+    UINT64 GetStateHash();
+
+    void SetRewindEnabled(bool enabled) { isRewindEnabled = enabled; }
+    LPREWINDBUFFER GetRewindBuffer() { return &rewind; }
+
+    // While rewinding, each Update goes one captured frame back instead of simulating one
+    void SetRewinding(bool rewinding) { isRewinding = rewinding; }
+    bool IsRewinding() { return isRewinding; }
 
     void Clear();
     void PurgeDeletedObjects();
-
-    static bool IsGameObjectDeleted(const LPGAMEOBJECT &o);
 };
 
 typedef CPlayScene *LPPLAYSCENE;
@@ -0,0 +1,95 @@
+#include "PlaySceneBatch.hpp"
+
+CPlaySceneBatch::CPlaySceneBatch(LPCWSTR sceneFile, int count, LPWORKERPOOL pool) {
+    this->pool = pool != NULL ? pool : CWorkerPool::GetInstance();
+
+    for (int i = 0; i < count; i++) {
+        LPPLAYSCENE scene = new CPlayScene(-1, sceneFile, true);
+        scene->SetViewSize(PLAY_SCENE_BATCH_VIEW_WIDTH, PLAY_SCENE_BATCH_VIEW_HEIGHT);
+        scene->Load();
+        scene->Enter();
+        scenes.push_back(scene);
+    }
+
+    episodes.resize(count);
+    rewards.resize(count);
+    dones.resize(count);
+    for (int i = 0; i < count; i++)
+        ResetEpisode(i);
+}
+
+CPlaySceneBatch::~CPlaySceneBatch() {
+    for (size_t i = 0; i < scenes.size(); i++) {
+        scenes[i]->Unload();
+        delete scenes[i];
+    }
+}
+
+void CPlaySceneBatch::ResetEpisode(size_t i) {
+    LPPLAYSCENE scene = scenes[i];
+    scene->Reset();
+
+    CEpisode &episode = episodes[i];
+    float y;
+    episode.steps = 0;
+    episode.previousInput = 0;
+    scene->GetPlayer()->GetPosition(episode.farthestX, y);
+    episode.coins = ((CMario *)scene->GetPlayer())->GetCoin();
+}
+
+/*
+    Runs on a worker: only touches scene i and its entries
+*/
+void CPlaySceneBatch::StepScene(size_t i, int input) {
+    LPPLAYSCENE scene = scenes[i];
+    CEpisode &episode = episodes[i];
+    CMario *mario = (CMario *)scene->GetPlayer();
+
+    mario->SetInput(input, episode.previousInput);
+    episode.previousInput = input;
+
+    scene->Update(PLAY_SCENE_BATCH_STEP);
+    episode.steps++;
+
+    float x, y;
+    mario->GetPosition(x, y);
+
+    float reward = 0;
+    if (x > episode.farthestX) {
+        reward += (x - episode.farthestX) * PLAY_SCENE_BATCH_REWARD_PROGRESS;
+        episode.farthestX = x;
+    }
+    reward += (mario->GetCoin() - episode.coins) * PLAY_SCENE_BATCH_REWARD_COIN;
+    episode.coins = mario->GetCoin();
+
+    bool isDone = false;
+    if (scene->GetPortalSceneId() >= 0) {
+        reward += PLAY_SCENE_BATCH_REWARD_PORTAL;
+        isDone = true;
+    } else if (mario->GetState() == MARIO_STATE_DIE || y > PLAY_SCENE_BATCH_FALL_Y) {
+        reward += PLAY_SCENE_BATCH_REWARD_DEATH;
+        isDone = true;
+    } else if (episode.steps >= PLAY_SCENE_BATCH_MAX_STEPS)
+        isDone = true;
+
+    rewards[i] = reward;
+    dones[i] = isDone ? 1 : 0;
+
+    if (isDone)
+        ResetEpisode(i);
+}
+
+void CPlaySceneBatch::Step(const BYTE *inputs) {
+    pool->ParallelFor(scenes.size(), 1, [this, inputs](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++)
+            StepScene(i, inputs[i]);
+    });
+}
+
+void CPlaySceneBatch::Reset() {
+    for (size_t i = 0; i < scenes.size(); i++) {
+        ResetEpisode(i);
+        rewards[i] = 0;
+        dones[i] = 0;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+#include "PlayScene.hpp"
+#include "WorkerPool.hpp"
+
+using namespace std;
+
+#define PLAY_SCENE_BATCH_STEP 10 // ms simulated per Step, same as the game loop
+
+// The view the camera of each scene works with, as the game window
+#define PLAY_SCENE_BATCH_VIEW_WIDTH 320
+#define PLAY_SCENE_BATCH_VIEW_HEIGHT 240
+
+// Steps before an episode is cut short: a minute of play
+#define PLAY_SCENE_BATCH_MAX_STEPS 6000
+
+// Below this the player fell off the level, and the episode is over
+#define PLAY_SCENE_BATCH_FALL_Y 400.0f
+
+// Rewards: per pixel the player got further right than ever in the episode, per coin collected,
+// and when the episode ends through a portal or by dying
+#define PLAY_SCENE_BATCH_REWARD_PROGRESS 0.01f
+#define PLAY_SCENE_BATCH_REWARD_COIN 1.0f
+#define PLAY_SCENE_BATCH_REWARD_PORTAL 10.0f
+#define PLAY_SCENE_BATCH_REWARD_DEATH -10.0f
+
+/*
+    N copies of a level, stepped together: for bots and automated balancing
+
+    Every copy is its own isolated CPlayScene (see CPlayScene::isIsolated): Step drives the
+    player of each from its input, then updates all of them in parallel on the worker pool,
+    one scene per task. Rewards and done flags come back in contiguous buffers, one entry per
+    scene. A scene whose episode is done is reset to its loaded state right away, so the next
+    Step starts a new episode
+*/
+class CPlaySceneBatch {
+    struct CEpisode {
+        int steps;
+        int previousInput;
+        float farthestX;
+        int coins;
+    };
+
+    vector<LPPLAYSCENE> scenes;
+    vector<CEpisode> episodes;
+    vector<float> rewards;
+    vector<BYTE> dones;
+
+    LPWORKERPOOL pool;
+
+    void StepScene(size_t i, int input);
+    void ResetEpisode(size_t i);
+
+public:
+    // count scenes loaded from sceneFile (only its objects, assets are never loaded). pool: the
+    // shared worker pool when NULL
+    CPlaySceneBatch(LPCWSTR sceneFile, int count, LPWORKERPOOL pool = NULL);
+    ~CPlaySceneBatch();
+
+    // inputs: one MARIO_INPUT_xxx mask per scene
+    void Step(const BYTE *inputs);
+
+    // Of the last Step, one per scene
+    const float *GetRewards() { return rewards.data(); }
+    const BYTE *GetDones() { return dones.data(); }
+
+    // Start a new episode in every scene
+    void Reset();
+
+    int GetCount() { return (int)scenes.size(); }
+    LPPLAYSCENE GetScene(int i) { return scenes[i]; }
+};
+
+typedef CPlaySceneBatch *LPPLAYSCENEBATCH;
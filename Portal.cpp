@@ -3,6 +3,8 @@
 #include "Textures.hpp"
 
 CPortal::CPortal(float l, float t, float r, float b, int scene_id) {
+    this->type = OBJECT_TYPE_PORTAL;
+    SetCollisionLayer(COLLISION_LAYER_PORTAL, COLLISION_MASK_PORTAL);
     this->scene_id = scene_id;
     x = l;
     y = t;
@@ -18,7 +20,7 @@ void CPortal::RenderBoundingBox() {
 
     float l, t, r, b;
 
-    GetBoundingBox(l, t, r, b);
+    GetCachedBoundingBox(l, t, r, b);
     rect.left = 0;
     rect.top = 0;
     rect.right = (int)r - (int)l;
@@ -39,4 +41,18 @@ void CPortal::GetBoundingBox(float &l, float &t, float &r, float &b) {
     t = y - height / 2;
     r = x + width / 2;
     b = y + height / 2;
-}
\ No newline at end of file
+}
+
+void CPortal::Save(CSaveWriter &w) {
+    CGameObject::Save(w);
+    w.Write(scene_id);
+    w.Write(width);
+    w.Write(height);
+}
+
+void CPortal::Restore(CSaveReader &r) {
+    CGameObject::Restore(r);
+    r.Read(scene_id);
+    r.Read(width);
+    r.Read(height);
+}
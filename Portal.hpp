@@ -20,4 +20,7 @@ public:
 
     int GetSceneId() { return scene_id; }
     int IsBlocking() { return 0; }
+
+    void Save(CSaveWriter &w);
+    void Restore(CSaveReader &r);
 };
\ No newline at end of file
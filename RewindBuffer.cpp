@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "PlayScene.hpp"
+#include "RewindBuffer.hpp"
+#include "SaveState.hpp"
+
+typedef std::chrono::steady_clock CRewindClock;
+
+CRewindBuffer::CRewindBuffer() {
+    frames.resize(REWIND_RING_FRAMES);
+    keyframes.resize(REWIND_KEYFRAMES);
+    first = count = 0;
+    nextKeyframe = 0;
+    ResetStats();
+}
+
+/*
+    Runs of equal bytes are skipped a word at a time, which is where nearly all of the state is.
+    Equal bytes at the end are left out
+*/
+void CRewindBuffer::Encode(const vector<BYTE> &state, const vector<BYTE> &keyframe, vector<BYTE> &delta) {
+    const BYTE *s = &state[0];
+    const BYTE *k = &keyframe[0];
+    size_t n = state.size();
+
+    delta.clear();
+    size_t i = 0;
+    while (i < n) {
+        size_t start = i;
+        while (i + sizeof(UINT64) <= n && memcmp(s + i, k + i, sizeof(UINT64)) == 0)
+            i += sizeof(UINT64);
+        while (i < n && s[i] == k[i])
+            i++;
+        if (i == n)
+            break;
+        size_t skip = i - start;
+
+        start = i;
+        while (i < n) {
+            if (s[i] != k[i]) {
+                i++;
+                continue;
+            }
+
+            size_t j = i;
+            while (j < n && j - i < REWIND_MIN_EQUAL_RUN && s[j] == k[j])
+                j++;
+            if (j - i == REWIND_MIN_EQUAL_RUN || j == n)
+                break;
+            i = j;
+        }
+
+        WriteVarint(delta, skip);
+        WriteVarint(delta, i - start);
+        for (size_t c = start; c < i; c++)
+            delta.push_back(s[c] ^ k[c]);
+    }
+}
+
+void CRewindBuffer::Decode(const vector<BYTE> &delta, const vector<BYTE> &keyframe, vector<BYTE> &state) {
+    state = keyframe;
+
+    const BYTE *p = delta.empty() ? NULL : &delta[0];
+    const BYTE *end = p + delta.size();
+    size_t i = 0;
+    while (p < end) {
+        i += ReadVarint(p, end);
+        size_t length = ReadVarint(p, end);
+        for (size_t c = 0; c < length; c++)
+            state[i++] ^= *p++;
+    }
+}
+
+void CRewindBuffer::DropOldest() {
+    first = GetSlot(1);
+    count--;
+}
+
+void CRewindBuffer::Capture(LPPLAYSCENE scene) {
+    CRewindClock::time_point start = CRewindClock::now();
+
+    scene->SaveState(state);
+
+    if (count == frames.size()) {
+        DropOldest();
+        while (count > 0 && frames[first].age != 0)
+            DropOldest();
+    }
+
+    CFrame *newest = count > 0 ? &frames[GetSlot(count - 1)] : NULL;
+    bool isKeyframe = newest == NULL || newest->age + 1 >= REWIND_KEYFRAME_INTERVAL ||
+                      keyframes[newest->keyframe].size() != state.size();
+
+    if (isKeyframe) {
+        size_t k = nextKeyframe;
+        nextKeyframe = (k + 1) % keyframes.size();
+        while (count > 0 && frames[first].keyframe == k)
+            DropOldest();
+
+        keyframes[k] = state;
+
+        CFrame &frame = frames[GetSlot(count)];
+        frame.delta.clear();
+        frame.keyframe = k;
+        frame.age = 0;
+        keyframeCaptures++;
+        keyframeBytes += state.size();
+    } else {
+        CFrame &frame = frames[GetSlot(count)];
+        Encode(state, keyframes[newest->keyframe], frame.delta);
+        frame.keyframe = newest->keyframe;
+        frame.age = newest->age + 1;
+        deltaBytes += frame.delta.size();
+    }
+    count++;
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(CRewindClock::now() - start).count();
+    captures++;
+    captureNs += ns;
+    maxCaptureNs = max(maxCaptureNs, ns);
+    if (ns > REWIND_CAPTURE_BUDGET_NS)
+        overBudget++;
+}
+
+bool CRewindBuffer::Rewind(LPPLAYSCENE scene) {
+    if (count < 2)
+        return false;
+    count--;
+
+    CFrame &frame = frames[GetSlot(count - 1)];
+    if (frame.age == 0)
+        return scene->RestoreState(keyframes[frame.keyframe]);
+
+    Decode(frame.delta, keyframes[frame.keyframe], state);
+    return scene->RestoreState(state);
+}
+
+void CRewindBuffer::Clear() {
+    first = count = 0;
+    nextKeyframe = 0;
+    for (size_t i = 0; i < frames.size(); i++)
+        vector<BYTE>().swap(frames[i].delta);
+    for (size_t i = 0; i < keyframes.size(); i++)
+        vector<BYTE>().swap(keyframes[i]);
+    vector<BYTE>().swap(state);
+}
+
+size_t CRewindBuffer::GetMemory() {
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++)
+        bytes += frames[GetSlot(i)].delta.size();
+    for (size_t i = 0; i < keyframes.size(); i++)
+        bytes += keyframes[i].size();
+    return bytes;
+}
+
+void CRewindBuffer::ResetStats() {
+    captures = keyframeCaptures = overBudget = 0;
+    captureNs = maxCaptureNs = 0;
+    keyframeBytes = deltaBytes = 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+#include "Game.hpp"
+
+using namespace std;
+
+// Seconds kept at least for rewinding
+#define REWIND_SECONDS 3
+
+// Frames kept at least for rewinding, one per Update, so one per SIMULATION_STEP
+#define REWIND_FRAMES (REWIND_SECONDS * 1000 / SIMULATION_STEP)
+
+// A full save state every this many frames, the frames between are stored as deltas against it
+#define REWIND_KEYFRAME_INTERVAL 30
+
+// Frames are dropped with their keyframe, a whole interval at a time, so the ring has room for one
+// more interval than REWIND_FRAMES
+#define REWIND_RING_FRAMES (REWIND_FRAMES + REWIND_KEYFRAME_INTERVAL)
+
+// Keyframes kept at most: those of a full ring and of the frame being captured. When states change
+// size often (many keyframes) fewer than REWIND_FRAMES frames are kept, but memory stays bounded
+#define REWIND_KEYFRAMES (REWIND_RING_FRAMES / REWIND_KEYFRAME_INTERVAL + 1)
+
+// Equal bytes needed to end a run of changed bytes in a delta, shorter runs cost more to encode
+// as a new run than to keep
+#define REWIND_MIN_EQUAL_RUN 4
+
+// Capture (save state plus delta) time per frame above which a frame counts as over budget
+#define REWIND_CAPTURE_BUDGET_NS 1000000.0
+
+class CPlayScene;
+typedef CPlayScene *LPPLAYSCENE;
+
+/*
+    The last REWIND_FRAMES (up to REWIND_RING_FRAMES) save states of a play scene, in a ring
+
+    Every REWIND_KEYFRAME_INTERVAL frames (or when the state size changes, as objects are spawned
+    or purged) a full save state is kept as a keyframe. The frames in between are stored as the
+    XOR of their save state with the keyframe, run-length encoded: as runs of equal bytes to skip
+    and runs of changed bytes, each a varint length. Most of a scene does not change within half
+    a second, so a delta is a small fraction of a keyframe.
+
+    Keyframes have a ring of their own, so only REWIND_KEYFRAMES buffers ever grow to the size of
+    a save state. Both rings reuse the buffers of dropped frames, so capturing does not allocate
+    once they have been filled. Frames depending on a dropped keyframe are dropped with it
+*/
+class CRewindBuffer {
+    struct CFrame {
+        vector<BYTE> delta; // empty for the keyframe itself
+        size_t keyframe;    // slot of its keyframe in keyframes
+        size_t age;         // frames since that keyframe, 0 for the keyframe itself
+    };
+
+    vector<CFrame> frames;
+    size_t first; // slot of the oldest frame
+    size_t count;
+
+    // Save states, allocated in turn: the slot taken next is the one of the oldest frames
+    vector<vector<BYTE>> keyframes;
+    size_t nextKeyframe;
+
+    vector<BYTE> state; // scratch save state
+
+    // instrumentation, since the last ResetStats
+    size_t captures;
+    size_t keyframeCaptures;
+    size_t overBudget;
+    double captureNs, maxCaptureNs;
+    size_t keyframeBytes, deltaBytes;
+
+    size_t GetSlot(size_t i) { return (first + i) % frames.size(); }
+    void DropOldest();
+
+    static void Encode(const vector<BYTE> &state, const vector<BYTE> &keyframe, vector<BYTE> &delta);
+    static void Decode(const vector<BYTE> &delta, const vector<BYTE> &keyframe, vector<BYTE> &state);
+
+public:
+    CRewindBuffer();
+
+    // Save the scene as the newest frame, dropping the oldest ones if the ring is full
+    void Capture(LPPLAYSCENE scene);
+
+    // Drop the newest frame and restore the scene to the one before it. False, with the scene
+    // unchanged, when there is no older frame to go back to
+    bool Rewind(LPPLAYSCENE scene);
+
+    void Clear();
+
+    size_t GetFrameCount() { return count; }
+
+    // Bytes held by the frames in the ring
+    size_t GetMemory();
+
+    size_t GetCaptureCount() { return captures; }
+    size_t GetKeyframeCount() { return keyframeCaptures; }
+    size_t GetOverBudgetCount() { return overBudget; }
+    double GetAverageCaptureNs() { return captures > 0 ? captureNs / captures : 0; }
+    double GetMaxCaptureNs() { return maxCaptureNs; }
+    double GetAverageDeltaBytes() {
+        return captures > keyframeCaptures ? (double)deltaBytes / (captures - keyframeCaptures) : 0;
+    }
+    double GetAverageFrameBytes() {
+        return captures > 0 ? (double)(keyframeBytes + deltaBytes) / captures : 0;
+    }
+    void ResetStats();
+};
+
+typedef CRewindBuffer *LPREWINDBUFFER;
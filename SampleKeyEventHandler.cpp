@@ -27,7 +27,7 @@ void CSampleKeyHandler::OnKeyDown(int KeyCode) {
         mario->SetState(MARIO_STATE_DIE);
         break;
     case DIK_R: // reset
-        // Reload();
+        ((LPPLAYSCENE)CGame::GetInstance()->GetCurrentScene())->Reset();
         break;
     }
 }
@@ -48,7 +48,13 @@ void CSampleKeyHandler::OnKeyUp(int KeyCode) {
 
 void CSampleKeyHandler::KeyState(BYTE *states) {
     LPGAME game = CGame::GetInstance();
-    CMario *mario = (CMario *)((LPPLAYSCENE)CGame::GetInstance()->GetCurrentScene())->GetPlayer();
+    LPPLAYSCENE scene = (LPPLAYSCENE)game->GetCurrentScene();
+    CMario *mario = (CMario *)scene->GetPlayer();
+
+    // hold backspace to rewind
+    scene->SetRewinding(game->IsKeyDown(DIK_BACK) != 0);
+    if (scene->IsRewinding())
+        return;
 
     if (game->IsKeyDown(DIK_RIGHT)) {
         if (game->IsKeyDown(DIK_A))
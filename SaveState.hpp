@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+#define SAVE_STATE_MAGIC 0x5641534D // "MSAV"
+
+// Bump whenever what any Save writes changes: older save states are then refused
+#define SAVE_STATE_VERSION 3
+
+/*
+    Appends plain values to a save state blob, as raw bytes in the machine's layout
+
+    Save states are only meant to be restored by the same build on the same machine (reset,
+    rewind, replays), so nothing is converted. The blob grows by doubling and is trimmed to what
+    was written by Close; the caller keeps it between saves, so that once it has grown saving
+    does not allocate
+*/
+class CSaveWriter {
+    vector<BYTE> &data;
+    size_t size;
+
+public:
+    // Writes from the start of data, whatever it held
+    CSaveWriter(vector<BYTE> &data) : data(data) { size = 0; }
+    ~CSaveWriter() { Close(); }
+
+    template <class T> void Write(const T &value) {
+        if (size + sizeof(T) > data.size())
+            data.resize(max(data.size() * 2, size + sizeof(T) + 1024));
+        memcpy(&data[size], &value, sizeof(T));
+        size += sizeof(T);
+    }
+
+    // Write over sizeof(T) bytes already written at position
+    template <class T> void Patch(size_t position, const T &value) { memcpy(&data[position], &value, sizeof(T)); }
+
+    void Close() { data.resize(size); }
+
+    size_t GetSize() { return size; }
+};
+
+/*
+    Reads back what a CSaveWriter wrote. Reading past the end gives zeros and makes the reader
+    invalid, so a truncated blob is detected instead of read out of bounds
+*/
+class CSaveReader {
+    const BYTE *data;
+    size_t size;
+    size_t position;
+    bool isValid;
+
+public:
+    CSaveReader(const vector<BYTE> &data) {
+        this->data = data.empty() ? NULL : &data[0];
+        size = data.size();
+        position = 0;
+        isValid = true;
+    }
+
+    template <class T> void Read(T &value) {
+        if (position + sizeof(T) > size) {
+            memset(&value, 0, sizeof(T));
+            isValid = false;
+            return;
+        }
+        memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+    }
+
+    template <class T> T Read() {
+        T value;
+        Read(value);
+        return value;
+    }
+
+    // Move past size bytes without reading them
+    void Skip(size_t size) {
+        if (size > this->size - position) {
+            position = this->size;
+            isValid = false;
+            return;
+        }
+        position += size;
+    }
+
+    bool IsValid() { return isValid; }
+    size_t GetPosition() { return position; }
+    bool IsAtEnd() { return position == size; }
+};
+
+/*
+    Unsigned values in 7 bit groups, low first, the high bit set on all but the last: small ones,
+    the common case, take a single byte
+*/
+inline void WriteVarint(vector<BYTE> &out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back((BYTE)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((BYTE)value);
+}
+
+// Reads from p, moving it past the value. Stops at end: a truncated value reads as what it has
+inline size_t ReadVarint(const BYTE *&p, const BYTE *end) {
+    size_t value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        BYTE b = *p++;
+        value |= (size_t)(b & 0x7F) << shift;
+        if (b < 0x80)
+            break;
+    }
+    return value;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "KeyEventHandler.hpp"
 #include "debug.hpp"
 
@@ -12,15 +14,29 @@ protected:
     int id;
     LPCWSTR sceneFilePath;
 
+    std::atomic<bool> isLoadCancelled; // Load should stop as soon as it can, see CScenePrefetcher
+
 public:
     CScene(int id, LPCWSTR filePath) {
         this->id = id;
         this->sceneFilePath = filePath;
         this->key_handler = NULL;
+        this->isLoadCancelled = false;
     }
+    virtual ~CScene() {}
+
+    int GetId() { return id; }
 
     LPKEYEVENTHANDLER GetKeyEventHandler() { return key_handler; }
+
+    // A cancelled Load leaves the scene half loaded, it has to be unloaded
+    void SetLoadCancelled(bool cancelled) { isLoadCancelled = cancelled; }
+    bool IsLoadCancelled() { return isLoadCancelled; }
+
+    // Load may run on another thread and must not touch the game (camera, input...), Enter is called
+    // on the game thread once the scene has become the current one
     virtual void Load() = 0;
+    virtual void Enter() {}
     virtual void Unload() = 0;
     virtual void Update(DWORD dt) = 0;
     virtual void Render() = 0;
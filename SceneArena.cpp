@@ -0,0 +1,104 @@
+#include <new>
+
+#include "SceneArena.hpp"
+
+thread_local CSceneArena *CSceneArena::current = NULL;
+
+CSceneArena::CSceneArena() {
+    block = 0;
+    used = 0;
+    allocations = reuses = heapAllocations = 0;
+    for (int i = 0; i < SCENE_ARENA_SIZE_CLASSES; i++)
+        freeLists[i] = NULL;
+}
+
+CSceneArena::~CSceneArena() {
+    Release();
+}
+
+void *CSceneArena::Allocate(size_t size) {
+    size = (size + SCENE_ARENA_ALIGN - 1) / SCENE_ARENA_ALIGN * SCENE_ARENA_ALIGN;
+    allocations++;
+
+    size_t sizeClass = size / SCENE_ARENA_ALIGN;
+    if (sizeClass < SCENE_ARENA_SIZE_CLASSES && freeLists[sizeClass] != NULL) {
+        void *p = freeLists[sizeClass];
+        freeLists[sizeClass] = *(void **)p;
+        reuses++;
+        return p;
+    }
+
+    // too big for any block: give it a block of its own, in front of the one being filled
+    if (size > SCENE_ARENA_BLOCK_SIZE) {
+        char *p = (char *)::operator new(size);
+        heapAllocations++;
+        blocks.insert(blocks.begin() + block, p);
+        block++;
+        return p;
+    }
+
+    if (block < blocks.size() && used + size > SCENE_ARENA_BLOCK_SIZE) {
+        block++;
+        used = 0;
+    }
+
+    if (block == blocks.size()) {
+        blocks.push_back((char *)::operator new(SCENE_ARENA_BLOCK_SIZE));
+        heapAllocations++;
+        used = 0;
+    }
+
+    void *p = blocks[block] + used;
+    used += size;
+    return p;
+}
+
+void CSceneArena::Free(void *p, size_t size) {
+    size = (size + SCENE_ARENA_ALIGN - 1) / SCENE_ARENA_ALIGN * SCENE_ARENA_ALIGN;
+
+    // bigger chunks stay unused until Reset
+    size_t sizeClass = size / SCENE_ARENA_ALIGN;
+    if (sizeClass >= SCENE_ARENA_SIZE_CLASSES)
+        return;
+
+    *(void **)p = freeLists[sizeClass];
+    freeLists[sizeClass] = p;
+}
+
+void CSceneArena::Reset() {
+    block = 0;
+    used = 0;
+    for (int i = 0; i < SCENE_ARENA_SIZE_CLASSES; i++)
+        freeLists[i] = NULL;
+}
+
+void CSceneArena::Release() {
+    for (size_t i = 0; i < blocks.size(); i++)
+        ::operator delete(blocks[i]);
+    blocks.clear();
+    Reset();
+}
+
+/*
+    Every chunk starts with a SCENE_ARENA_ALIGN bytes header holding its arena (NULL for the heap),
+    so that Delete can give it back to the right place whichever arena is current
+*/
+void *CSceneArena::New(size_t size) {
+    size_t total = size + SCENE_ARENA_ALIGN;
+    char *p = current != NULL ? (char *)current->Allocate(total) : (char *)::operator new(total);
+
+    *(CSceneArena **)p = current;
+    return p + SCENE_ARENA_ALIGN;
+}
+
+void CSceneArena::Delete(void *p, size_t size) {
+    if (p == NULL)
+        return;
+
+    char *chunk = (char *)p - SCENE_ARENA_ALIGN;
+    CSceneArena *arena = *(CSceneArena **)chunk;
+    if (arena != NULL)
+        arena->Free(chunk, size + SCENE_ARENA_ALIGN);
+    else
+        ::operator delete(chunk);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+#define SCENE_ARENA_BLOCK_SIZE (64 * 1024)
+#define SCENE_ARENA_ALIGN 16         // every allocation starts on this boundary
+#define SCENE_ARENA_SIZE_CLASSES 64 // freed memory up to 64 * SCENE_ARENA_ALIGN bytes is reused
+
+/*
+    Memory of everything a scene creates while loading: game objects, animations and their frames
+
+    Allocation bumps a pointer in 64 KB blocks, and memory freed mid-scene (a purged object) goes to
+    a free list of its size, so the next object of the same type takes it back. Reset drops all
+    of it at once when the scene is unloaded; the blocks are kept, so loading a scene again costs
+    no heap allocation until it needs more memory than before.
+
+    Classes opt in with an operator new / delete calling New and Delete. While a scene loads it
+    makes its arena current (per thread), allocations made with no current arena use the heap
+*/
+class CSceneArena {
+    vector<char *> blocks;
+    size_t block; // block being filled
+    size_t used;  // bytes used in that block
+
+    void *freeLists[SCENE_ARENA_SIZE_CLASSES]; // freed chunks, linked through their first bytes
+
+    size_t allocations, reuses, heapAllocations;
+
+    static thread_local CSceneArena *current;
+
+public:
+    CSceneArena();
+    ~CSceneArena();
+
+    void *Allocate(size_t size);
+    void Free(void *p, size_t size);
+
+    // Forget every allocation made so far. Objects must have been destroyed before
+    void Reset();
+
+    // Same as Reset, and give the blocks back to the heap
+    void Release();
+
+    size_t GetAllocationCount() { return allocations; }
+    size_t GetReuseCount() { return reuses; }
+    size_t GetHeapAllocationCount() { return heapAllocations; }
+    size_t GetCapacity() { return blocks.size() * SCENE_ARENA_BLOCK_SIZE; }
+
+    static void SetCurrent(CSceneArena *arena) { current = arena; }
+    static CSceneArena *GetCurrent() { return current; }
+
+    // Allocate from the current arena (or the heap), the memory remembers where it came from
+    static void *New(size_t size);
+    static void Delete(void *p, size_t size);
+};
+
+typedef CSceneArena *LPSCENEARENA;
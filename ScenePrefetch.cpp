@@ -0,0 +1,117 @@
+#include "ScenePrefetch.hpp"
+#include "debug.hpp"
+
+CScenePrefetcher *CScenePrefetcher::__instance = NULL;
+
+CScenePrefetcher *CScenePrefetcher::GetInstance() {
+    if (__instance == NULL)
+        __instance = new CScenePrefetcher();
+    return __instance;
+}
+
+CScenePrefetcher::CScenePrefetcher() {
+    scene = NULL;
+    isLoading = false;
+    quit = false;
+}
+
+CScenePrefetcher::~CScenePrefetcher() {
+    Cancel();
+
+    {
+        unique_lock<mutex> l(lock);
+        quit = true;
+    }
+    wake.notify_all();
+
+    if (worker.joinable())
+        worker.join();
+}
+
+void CScenePrefetcher::WorkerMain() {
+    unique_lock<mutex> l(lock);
+
+    while (true) {
+        wake.wait(l, [this] { return quit || isLoading; });
+        if (quit)
+            return;
+
+        LPSCENE s = scene;
+        l.unlock();
+
+        CSprites::SetLoading(&sprites);
+        CAnimations::SetLoading(&animations);
+        s->Load();
+        CSprites::SetLoading(NULL);
+        CAnimations::SetLoading(NULL);
+
+        l.lock();
+        isLoading = false;
+        done.notify_all();
+    }
+}
+
+void CScenePrefetcher::WaitLoaded() {
+    unique_lock<mutex> l(lock);
+    done.wait(l, [this] { return !isLoading; });
+}
+
+void CScenePrefetcher::Request(LPSCENE scene) {
+    if (scene == this->scene)
+        return;
+    Cancel();
+
+    if (!worker.joinable())
+        worker = thread(&CScenePrefetcher::WorkerMain, this);
+
+    DebugOut(L"[INFO] Prefetching scene %d\n", scene->GetId());
+
+    unique_lock<mutex> l(lock);
+    this->scene = scene;
+    scene->SetLoadCancelled(false);
+    isLoading = true;
+    wake.notify_one();
+}
+
+/*
+    The scene stops loading at its next line, then is unloaded here with the staging sprites and
+    animations in place of the shared ones, so that only what the prefetch loaded goes away
+*/
+void CScenePrefetcher::Cancel() {
+    if (scene == NULL)
+        return;
+
+    scene->SetLoadCancelled(true);
+    WaitLoaded();
+
+    CSprites::SetLoading(&sprites);
+    CAnimations::SetLoading(&animations);
+    scene->Unload();
+    sprites.Clear();
+    animations.Clear();
+    CSprites::SetLoading(NULL);
+    CAnimations::SetLoading(NULL);
+
+    DebugOut(L"[INFO] Prefetch of scene %d cancelled\n", scene->GetId());
+
+    scene->SetLoadCancelled(false);
+    scene = NULL;
+}
+
+bool CScenePrefetcher::Take(LPSCENE scene) {
+    if (scene == NULL || scene != this->scene)
+        return false;
+
+    // still loading when the player got to the portal fast: it is finished sooner than a new load
+    WaitLoaded();
+
+    CSprites::GetInstance()->Swap(&sprites);
+    CAnimations::GetInstance()->Swap(&animations);
+
+    // whatever the shared tables held before came back into staging
+    sprites.Clear();
+    animations.Clear();
+
+    this->scene = NULL;
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <windows.h>
+
+#include "Animations.hpp"
+#include "Scene.hpp"
+#include "Sprites.hpp"
+
+using namespace std;
+
+/*
+    Loads one scene at a time on a background thread, so that switching to it does not stall
+
+    The scene loads into its own arena (CSceneArena is per thread) and into staging CSprites and
+    CAnimations (see CSprites::SetLoading), so nothing in use by the current scene is touched.
+    Take hands the staged sprites and animations over when the game switches to the scene; a
+    prefetch that is no longer wanted is cancelled and its scene unloaded.
+
+    Request, Cancel and Take are called from the game thread only
+*/
+class CScenePrefetcher {
+    static CScenePrefetcher *__instance;
+
+    thread worker; // started by the first Request
+
+    mutex lock;
+    condition_variable wake; // signaled when a scene is requested or the prefetcher shuts down
+    condition_variable done; // signaled when the worker finished loading
+    LPSCENE scene;           // being loaded or loaded, NULL when idle
+    bool isLoading;
+    bool quit;
+
+    CSprites sprites;
+    CAnimations animations;
+
+    void WorkerMain();
+    void WaitLoaded();
+
+public:
+    CScenePrefetcher();
+    ~CScenePrefetcher();
+
+    // Start loading scene, unless it is the one already prefetched. Any other prefetch is cancelled
+    void Request(LPSCENE scene);
+
+    // Stop the prefetch and unload what it loaded, if any
+    void Cancel();
+
+    // Finish the prefetch of scene and make its sprites and animations the ones in use, the
+    // previous ones must have been cleared. False (nothing done) if scene was not prefetched
+    bool Take(LPSCENE scene);
+
+    LPSCENE GetScene() { return scene; }
+
+    static CScenePrefetcher *GetInstance();
+};
+
+typedef CScenePrefetcher *LPSCENEPREFETCHER;
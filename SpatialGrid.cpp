@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cmath>
+
+#include "GameObject.hpp"
+#include "SpatialGrid.hpp"
+
+/*
+    Cells covered by the bounding box of obj swept along its movement over dt
+*/
+void CSpatialGrid::GetCellRange(LPGAMEOBJECT obj, DWORD dt, int &l, int &t, int &r, int &b) {
+    float left, top, right, bottom;
+    GetSweptBox(obj, dt, left, top, right, bottom);
+
+    l = (int)floor(left / cellSize);
+    t = (int)floor(top / cellSize);
+    r = (int)floor(right / cellSize);
+    b = (int)floor(bottom / cellSize);
+}
+
+void CSpatialGrid::AddToCells(int id) {
+    CGridEntry &e = entries[id];
+    for (int cy = e.t; cy <= e.b; cy++)
+        for (int cx = e.l; cx <= e.r; cx++)
+            cells[CellKey(cx, cy)].push_back(id);
+}
+
+void CSpatialGrid::RemoveFromCells(int id) {
+    CGridEntry &e = entries[id];
+    for (int cy = e.t; cy <= e.b; cy++)
+        for (int cx = e.l; cx <= e.r; cx++) {
+            auto it = cells.find(CellKey(cx, cy));
+            if (it == cells.end())
+                continue;
+
+            // empty cells are kept so that moving objects back into them does not allocate
+            vector<int> &cell = it->second;
+            cell.erase(std::remove(cell.begin(), cell.end(), id), cell.end());
+        }
+}
+
+void CSpatialGrid::Insert(LPGAMEOBJECT obj, DWORD dt) {
+    if (ids.find(obj) != ids.end()) {
+        Update(obj, dt);
+        return;
+    }
+
+    int id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = (int)entries.size();
+        entries.push_back(CGridEntry());
+    }
+
+    CGridEntry &e = entries[id];
+    e.obj = obj;
+    GetCellRange(obj, dt, e.l, e.t, e.r, e.b);
+    ids[obj] = id;
+
+    AddToCells(id);
+}
+
+/*
+    Re-bucket obj after it moved. Cheap when the covered cells did not change, which is the
+    case for static objects and for most moving objects on most frames
+*/
+void CSpatialGrid::Update(LPGAMEOBJECT obj, DWORD dt) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    int id = it->second;
+    int l, t, r, b;
+    GetCellRange(obj, dt, l, t, r, b);
+
+    CGridEntry &e = entries[id];
+    if (l == e.l && t == e.t && r == e.r && b == e.b)
+        return;
+
+    RemoveFromCells(id);
+    e.l = l;
+    e.t = t;
+    e.r = r;
+    e.b = b;
+    AddToCells(id);
+}
+
+void CSpatialGrid::Remove(LPGAMEOBJECT obj) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    int id = it->second;
+    RemoveFromCells(id);
+    entries[id].obj = NULL;
+    ids.erase(it);
+    freeIds.push_back(id);
+}
+
+void CSpatialGrid::Clear() {
+    cells.clear();
+    ids.clear();
+    entries.clear();
+    freeIds.clear();
+}
+
+/*
+    Collect every object whose cells overlap the box (l, t, r, b)
+    Results are appended to result in entry id order, without duplicates
+*/
+void CSpatialGrid::Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result, vector<int> &found) const {
+    int cl = (int)floor(l / cellSize);
+    int ct = (int)floor(t / cellSize);
+    int cr = (int)floor(r / cellSize);
+    int cb = (int)floor(b / cellSize);
+
+    found.clear();
+
+    for (int cy = ct; cy <= cb; cy++)
+        for (int cx = cl; cx <= cr; cx++) {
+            auto it = cells.find(CellKey(cx, cy));
+            if (it == cells.end())
+                continue;
+
+            const vector<int> &cell = it->second;
+            found.insert(found.end(), cell.begin(), cell.end());
+        }
+
+    // objects spanning several cells were collected once per cell
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    for (size_t i = 0; i < found.size(); i++)
+        result.push_back(entries[found[i]].obj);
+}
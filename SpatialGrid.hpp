@@ -0,0 +1,58 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+
+#include "Broadphase.hpp"
+
+using namespace std;
+
+#define GRID_CELL_SIZE 64.0f
+
+/*
+    Uniform spatial hash used as collision broadphase
+
+    Every object is bucketed by its swept bounding box (current box + movement over dt).
+    A query returns each object overlapping the queried cells exactly once, in entry id order:
+    insertion order, except that the ids of removed objects are reused by the next inserts, so
+    that sleeping, waking and streaming objects in and out does not grow the entries forever.
+*/
+class CSpatialGrid : public CBroadphase {
+    struct CGridEntry {
+        LPGAMEOBJECT obj;
+        int l, t, r, b; // covered cell range
+    };
+
+    float cellSize;
+
+    unordered_map<long long, vector<int>> cells; // cell key -> entry ids
+    unordered_map<LPGAMEOBJECT, int> ids;        // object -> entry id
+    vector<CGridEntry> entries;                  // by entry id, obj NULL while free
+    vector<int> freeIds;                         // entry ids of removed objects, reused first
+
+    static long long CellKey(int cx, int cy) {
+        return ((long long)cx << 32) ^ (unsigned int)cy;
+    }
+
+    void GetCellRange(LPGAMEOBJECT obj, DWORD dt, int &l, int &t, int &r, int &b);
+    void AddToCells(int id);
+    void RemoveFromCells(int id);
+
+public:
+    CSpatialGrid(float cellSize = GRID_CELL_SIZE) {
+        this->cellSize = cellSize;
+    }
+
+    virtual void Insert(LPGAMEOBJECT obj, DWORD dt = 0);
+    virtual void Update(LPGAMEOBJECT obj, DWORD dt);
+    virtual void Remove(LPGAMEOBJECT obj);
+    virtual void Clear();
+
+    using CBroadphase::Query;
+    virtual void Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result, vector<int> &found) const;
+
+    virtual size_t GetSize() { return ids.size(); }
+};
+
+typedef CSpatialGrid *LPSPATIALGRID;
@@ -0,0 +1,156 @@
+#include <algorithm>
+
+#include "Collision.hpp"
+#include "GameObject.hpp"
+#include "SpatialQuery.hpp"
+
+/*
+    Objects that may overlap (l, t, r, b), from the broadphase, the static layer and the player
+*/
+void CSpatialQuery::GetCandidates(float l, float t, float r, float b, UINT layers, LPGAMEOBJECT ignore) {
+    candidates.clear();
+
+    if (broadphase != NULL)
+        broadphase->Query(l, t, r, b, candidates, found);
+    if (staticLayer != NULL)
+        staticLayer->Query(l, t, r, b, layers, candidates, found);
+    if (player != NULL)
+        candidates.push_back(player);
+
+    size_t n = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        LPGAMEOBJECT obj = candidates[i];
+        if (obj == ignore || obj->IsDeleted() || (obj->GetCollisionLayer() & layers) == 0)
+            continue;
+        candidates[n++] = obj;
+    }
+    candidates.resize(n);
+}
+
+void CSpatialQuery::Overlap(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result,
+                            UINT layers, LPGAMEOBJECT ignore) {
+    result.clear();
+    GetCandidates(l, t, r, b, layers, ignore);
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        float sl, st, sr, sb;
+        candidates[i]->GetCachedBoundingBox(sl, st, sr, sb);
+        if (sl < r && sr > l && st < b && sb > t)
+            result.push_back(candidates[i]);
+    }
+}
+
+void CSpatialQuery::Point(float x, float y, vector<LPGAMEOBJECT> &result, UINT layers, LPGAMEOBJECT ignore) {
+    result.clear();
+    GetCandidates(x, y, x, y, layers, ignore);
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        float sl, st, sr, sb;
+        candidates[i]->GetCachedBoundingBox(sl, st, sr, sb);
+        if (sl <= x && x < sr && st <= y && y < sb)
+            result.push_back(candidates[i]);
+    }
+}
+
+/*
+    Slab test of the segment against every candidate box, keeping the smallest entry time
+*/
+bool CSpatialQuery::Raycast(float x0, float y0, float x1, float y1, CSpatialHit &hit,
+                            UINT layers, LPGAMEOBJECT ignore) {
+    GetCandidates(min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1), layers, ignore);
+
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+
+    hit.obj = NULL;
+    hit.t = 2.0f;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        float sl, st, sr, sb;
+        candidates[i]->GetCachedBoundingBox(sl, st, sr, sb);
+
+        float tEntry = 0.0f, tExit = 1.0f;
+        float nx = 0, ny = 0;
+
+        if (dx == 0) {
+            if (x0 < sl || x0 > sr)
+                continue;
+        } else {
+            float ta = (sl - x0) / dx;
+            float tb = (sr - x0) / dx;
+            if (ta > tb)
+                swap(ta, tb);
+            if (ta > tEntry) {
+                tEntry = ta;
+                nx = dx > 0 ? -1.0f : 1.0f;
+            }
+            tExit = min(tExit, tb);
+        }
+
+        if (dy == 0) {
+            if (y0 < st || y0 > sb)
+                continue;
+        } else {
+            float ta = (st - y0) / dy;
+            float tb = (sb - y0) / dy;
+            if (ta > tb)
+                swap(ta, tb);
+            if (ta > tEntry) {
+                tEntry = ta;
+                nx = 0;
+                ny = dy > 0 ? -1.0f : 1.0f;
+            }
+            tExit = min(tExit, tb);
+        }
+
+        if (tEntry > tExit || tEntry >= hit.t)
+            continue;
+
+        hit.obj = candidates[i];
+        hit.t = tEntry;
+        hit.nx = nx;
+        hit.ny = ny;
+    }
+
+    if (hit.obj == NULL)
+        return false;
+
+    hit.x = x0 + dx * hit.t;
+    hit.y = y0 + dy * hit.t;
+    return true;
+}
+
+bool CSpatialQuery::SweepBox(float l, float t, float r, float b, float dx, float dy, CSpatialHit &hit,
+                             UINT layers, LPGAMEOBJECT ignore) {
+    GetCandidates(
+        dx < 0 ? l + dx : l,
+        dy < 0 ? t + dy : t,
+        dx > 0 ? r + dx : r,
+        dy > 0 ? b + dy : b,
+        layers, ignore);
+
+    hit.obj = NULL;
+    hit.t = 2.0f;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        float sl, st, sr, sb;
+        candidates[i]->GetCachedBoundingBox(sl, st, sr, sb);
+
+        float ht, nx, ny;
+        CCollision::SweptAABB(l, t, r, b, dx, dy, sl, st, sr, sb, ht, nx, ny);
+        if (ht < 0.0f || ht > 1.0f || ht >= hit.t)
+            continue;
+
+        hit.obj = candidates[i];
+        hit.t = ht;
+        hit.nx = nx;
+        hit.ny = ny;
+    }
+
+    if (hit.obj == NULL)
+        return false;
+
+    hit.x = l + dx * hit.t;
+    hit.y = t + dy * hit.t;
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <windows.h>
+
+#include "AssetIDs.hpp"
+#include "Broadphase.hpp"
+#include "StaticLayer.hpp"
+
+using namespace std;
+
+/*
+    Nearest hit of a ray or swept box query
+*/
+struct CSpatialHit {
+    LPGAMEOBJECT obj;
+    float t;      // fraction of the segment / movement travelled before the hit, in [0, 1]
+    float x, y;   // where the ray or the box (its left-top corner) is at t
+    float nx, ny; // normal of the hit side, 0, 0 when the ray starts inside obj
+};
+
+/*
+    Spatial queries against the objects of a play scene
+
+    Moving objects are looked up in the scene's broadphase and static objects in its static layer,
+    so a query only tests the objects near the queried area. The player is not in either of them
+    and is tested on its own. Sleeping moving objects (see CActivationRegion) are not in the
+    broadphase and are never returned; static objects stay in the static layer while asleep, so
+    they are.
+
+    Boxes are half-open, [l, r) x [t, b), the queried ones as those of the objects: Overlap does
+    not return objects that only touch the queried box, and a point on the edge shared by two
+    boxes is only in the right (or bottom) one, for Point as for Overlap around the point.
+    Raycast and SweepBox report where the ray or the box first reaches an object's box instead.
+
+    Every query only takes objects whose collision layer is in layers, skips ignore and deleted
+    objects, and writes its results into the buffers given by the caller: once those have grown,
+    queries do not allocate. Results of Overlap and Point come in no particular order
+*/
+class CSpatialQuery {
+    LPBROADPHASE broadphase;
+    LPSTATICLAYER staticLayer;
+    LPGAMEOBJECT player;
+
+    vector<LPGAMEOBJECT> candidates;
+    vector<int> found;
+
+    void GetCandidates(float l, float t, float r, float b, UINT layers, LPGAMEOBJECT ignore);
+
+public:
+    CSpatialQuery() {
+        broadphase = NULL;
+        staticLayer = NULL;
+        player = NULL;
+    }
+
+    void SetSources(LPBROADPHASE broadphase, LPSTATICLAYER staticLayer, LPGAMEOBJECT player) {
+        this->broadphase = broadphase;
+        this->staticLayer = staticLayer;
+        this->player = player;
+    }
+
+    // Objects whose bounding box shares a point with (l, t, r, b)
+    void Overlap(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result,
+                 UINT layers = COLLISION_LAYER_ALL, LPGAMEOBJECT ignore = NULL);
+
+    // Objects whose bounding box contains (x, y)
+    void Point(float x, float y, vector<LPGAMEOBJECT> &result,
+               UINT layers = COLLISION_LAYER_ALL, LPGAMEOBJECT ignore = NULL);
+
+    // Nearest object crossed by the segment (x0, y0) - (x1, y1)
+    bool Raycast(float x0, float y0, float x1, float y1, CSpatialHit &hit,
+                 UINT layers = COLLISION_LAYER_ALL, LPGAMEOBJECT ignore = NULL);
+
+    // Nearest object hit by the box (l, t, r, b) moving by (dx, dy), same test as CCollision::SweptAABB
+    bool SweepBox(float l, float t, float r, float b, float dx, float dy, CSpatialHit &hit,
+                  UINT layers = COLLISION_LAYER_ALL, LPGAMEOBJECT ignore = NULL);
+};
+
+typedef CSpatialQuery *LPSPATIALQUERY;
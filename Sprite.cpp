@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "Sprite.hpp"
 
 CSprite::CSprite(int id, int left, int top, int right, int bottom, LPTEXTURE tex) {
@@ -8,6 +10,10 @@ CSprite::CSprite(int id, int left, int top, int right, int bottom, LPTEXTURE tex
     this->bottom = bottom;
     this->texture = tex;
 
+    // headless, never drawn
+    if (tex == NULL)
+        return;
+
     float texWidth = (float)tex->getWidth();
     float texHeight = (float)tex->getHeight();
 
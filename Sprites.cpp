@@ -3,8 +3,11 @@
 #include "debug.hpp"
 
 CSprites *CSprites::__instance = NULL;
+thread_local CSprites *CSprites::loading = NULL;
 
 CSprites *CSprites::GetInstance() {
+    if (loading != NULL)
+        return loading;
     if (__instance == NULL)
         __instance = new CSprites();
     return __instance;
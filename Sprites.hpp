@@ -14,6 +14,7 @@ using namespace std;
 */
 class CSprites {
     static CSprites *__instance;
+    static thread_local CSprites *loading; // see SetLoading
 
     unordered_map<int, LPSPRITE> sprites;
 
@@ -22,5 +23,12 @@ public:
     LPSPRITE Get(int id);
     void Clear();
 
+    // Exchange the contents with staging, see CScenePrefetcher
+    void Swap(CSprites *staging) { sprites.swap(staging->sprites); }
+
+    // Make GetInstance return staging on this thread, so that a scene loading in the background
+    // fills its own sprites instead of the ones in use. NULL goes back to the shared instance
+    static void SetLoading(CSprites *staging) { loading = staging; }
+
     static CSprites *GetInstance();
 };
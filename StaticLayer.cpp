@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+
+#include "GameObject.hpp"
+#include "StaticLayer.hpp"
+
+void CStaticLayer::Add(LPGAMEOBJECT obj) {
+    if (ids.find(obj) != ids.end())
+        return;
+
+    CStaticBox box;
+    obj->GetCachedBoundingBox(box.l, box.t, box.r, box.b);
+    box.obj = obj;
+    box.layer = obj->GetCollisionLayer();
+
+    ids[obj] = (int)boxes.size();
+    boxes.push_back(box);
+    isDirty = true;
+}
+
+/*
+    Build the tile grid from all boxes added so far. Must be called after the level has been parsed,
+    and again whenever objects were added or removed (see IsDirty). Removed boxes are dropped
+*/
+void CStaticLayer::Build() {
+    size_t kept = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        if (boxes[i].obj == NULL)
+            continue;
+        ids[boxes[i].obj] = (int)kept;
+        boxes[kept++] = boxes[i];
+    }
+    boxes.resize(kept);
+    isDirty = false;
+
+    tileStart.clear();
+    tileBoxes.clear();
+    columns = rows = 0;
+
+    if (boxes.empty())
+        return;
+
+    float minX = boxes[0].l, minY = boxes[0].t;
+    float maxX = boxes[0].r, maxY = boxes[0].b;
+    for (size_t i = 1; i < boxes.size(); i++) {
+        minX = min(minX, boxes[i].l);
+        minY = min(minY, boxes[i].t);
+        maxX = max(maxX, boxes[i].r);
+        maxY = max(maxY, boxes[i].b);
+    }
+
+    originX = floor(minX / STATIC_TILE_SIZE) * STATIC_TILE_SIZE;
+    originY = floor(minY / STATIC_TILE_SIZE) * STATIC_TILE_SIZE;
+    columns = (int)floor((maxX - originX) / STATIC_TILE_SIZE) + 1;
+    rows = (int)floor((maxY - originY) / STATIC_TILE_SIZE) + 1;
+
+    // count boxes per tile, then prefix-sum into tile offsets and fill
+    tileStart.assign(columns * rows + 1, 0);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        int cl, ct, cr, cb;
+        GetTileRange(boxes[i].l, boxes[i].t, boxes[i].r, boxes[i].b, cl, ct, cr, cb);
+        for (int cy = ct; cy <= cb; cy++)
+            for (int cx = cl; cx <= cr; cx++)
+                tileStart[cy * columns + cx + 1]++;
+    }
+
+    for (int i = 0; i < columns * rows; i++)
+        tileStart[i + 1] += tileStart[i];
+
+    tileBoxes.resize(tileStart[columns * rows]);
+    vector<int> cursor(tileStart.begin(), tileStart.end() - 1);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        int cl, ct, cr, cb;
+        GetTileRange(boxes[i].l, boxes[i].t, boxes[i].r, boxes[i].b, cl, ct, cr, cb);
+        for (int cy = ct; cy <= cb; cy++)
+            for (int cx = cl; cx <= cr; cx++)
+                tileBoxes[cursor[cy * columns + cx]++] = (int)i;
+    }
+}
+
+void CStaticLayer::Remove(LPGAMEOBJECT obj) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    boxes[it->second].obj = NULL;
+    ids.erase(it);
+    isDirty = true;
+}
+
+void CStaticLayer::Clear() {
+    boxes.clear();
+    ids.clear();
+    tileStart.clear();
+    tileBoxes.clear();
+    columns = rows = 0;
+    isDirty = false;
+}
+
+/*
+    Tile range covered by a box, clamped to the layer
+*/
+void CStaticLayer::GetTileRange(float l, float t, float r, float b, int &cl, int &ct, int &cr, int &cb) const {
+    cl = max(0, (int)floor((l - originX) / STATIC_TILE_SIZE));
+    ct = max(0, (int)floor((t - originY) / STATIC_TILE_SIZE));
+    cr = min(columns - 1, (int)floor((r - originX) / STATIC_TILE_SIZE));
+    cb = min(rows - 1, (int)floor((b - originY) / STATIC_TILE_SIZE));
+}
+
+/*
+    Sweep objSrc, whose box (ml, mt, mr, mb) moves by (dx, dy), against the static boxes in the
+    tiles it crosses
+
+    Static objects do not move, so the relative movement is simply the movement of objSrc.
+    Events are appended in insertion order. CCollision::Scan adds them before those of the moving
+    objects, see there for what that does to ties
+*/
+void CStaticLayer::Scan(LPGAMEOBJECT objSrc,
+                        float ml, float mt, float mr, float mb,
+                        float dx, float dy,
+                        CCollisionScratch &scratch,
+                        vector<CCollisionEvent> &coEvents) const {
+    if (columns == 0)
+        return;
+
+    UINT mask = objSrc->GetCollisionMask();
+
+    int cl, ct, cr, cb;
+    GetTileRange(
+        dx < 0 ? ml + dx : ml,
+        dy < 0 ? mt + dy : mt,
+        dx > 0 ? mr + dx : mr,
+        dy > 0 ? mb + dy : mb,
+        cl, ct, cr, cb);
+
+    vector<int> &found = scratch.found;
+    found.clear();
+
+    for (int cy = ct; cy <= cb; cy++)
+        for (int cx = cl; cx <= cr; cx++) {
+            int tile = cy * columns + cx;
+            for (int i = tileStart[tile]; i < tileStart[tile + 1]; i++) {
+                const CStaticBox &box = boxes[tileBoxes[i]];
+                if (box.obj != NULL && box.obj != objSrc)
+                    found.push_back(tileBoxes[i]);
+            }
+        }
+
+    // boxes spanning several tiles were collected once per tile
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    CSweptAABBBatch &batch = scratch.batch;
+    batch.Clear();
+    for (size_t i = 0; i < found.size(); i++) {
+        const CStaticBox &box = boxes[found[i]];
+        if ((box.layer & mask) == 0) {
+            scratch.pairsRejected++;
+            continue;
+        }
+        batch.Add(box.obj, box.l, box.t, box.r, box.b);
+    }
+
+    batch.Run(ml, mt, mr, mb, dx, dy);
+    scratch.pairsTested += batch.Size();
+
+    for (size_t i = 0; i < batch.Size(); i++) {
+        if (batch.t[i] >= 0.0f && batch.t[i] <= 1.0f)
+            coEvents.push_back(CCollisionEvent(batch.t[i], batch.nx[i], batch.ny[i], dx, dy, batch.obj[i], objSrc));
+    }
+}
+
+void CStaticLayer::Query(float l, float t, float r, float b, UINT layers,
+                         vector<LPGAMEOBJECT> &result, vector<int> &found) const {
+    if (columns == 0)
+        return;
+
+    int cl, ct, cr, cb;
+    GetTileRange(l, t, r, b, cl, ct, cr, cb);
+
+    found.clear();
+    for (int cy = ct; cy <= cb; cy++)
+        for (int cx = cl; cx <= cr; cx++) {
+            int tile = cy * columns + cx;
+            for (int i = tileStart[tile]; i < tileStart[tile + 1]; i++)
+                found.push_back(tileBoxes[i]);
+        }
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    for (size_t i = 0; i < found.size(); i++) {
+        const CStaticBox &box = boxes[found[i]];
+        if (box.obj == NULL || (box.layer & layers) == 0)
+            continue;
+        if (box.l <= r && box.r >= l && box.t <= b && box.b >= t)
+            result.push_back(box.obj);
+    }
+}
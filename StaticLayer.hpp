@@ -0,0 +1,71 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+
+#include "Collision.hpp"
+
+using namespace std;
+
+#define STATIC_TILE_SIZE 16.0f
+
+/*
+    Dense tile grid holding the bounding boxes of objects that never move (bricks, platforms)
+
+    Boxes are cached once when the level is loaded, so sweeping a moving object against the
+    layer only walks the tiles crossed by its swept box: no virtual call per static object.
+*/
+class CStaticLayer {
+    struct CStaticBox {
+        float l, t, r, b;
+        LPGAMEOBJECT obj; // NULL once removed
+        UINT layer;
+    };
+
+    vector<CStaticBox> boxes;              // in insertion order
+    unordered_map<LPGAMEOBJECT, int> ids;
+
+    // Tiles are stored CSR style: tile i holds tileBoxes[tileStart[i] .. tileStart[i + 1])
+    float originX, originY;
+    int columns, rows;
+    vector<int> tileStart;
+    vector<int> tileBoxes;
+
+    bool isDirty; // boxes added or removed since the last Build
+
+    void GetTileRange(float l, float t, float r, float b, int &cl, int &ct, int &cr, int &cb) const;
+
+public:
+    CStaticLayer() {
+        originX = originY = 0;
+        columns = rows = 0;
+        isDirty = false;
+    }
+
+    void Add(LPGAMEOBJECT obj);
+    void Build();
+    void Remove(LPGAMEOBJECT obj);
+    void Clear();
+
+    // Read only, several threads may scan at once with their own scratch buffers
+    void Scan(LPGAMEOBJECT objSrc,
+              float ml, float mt, float mr, float mb,
+              float dx, float dy,
+              CCollisionScratch &scratch,
+              vector<CCollisionEvent> &coEvents) const;
+
+    // Append the objects on one of the given layers whose box overlaps or touches (l, t, r, b), in
+    // insertion order. Touching ones are kept so that callers can apply their own edge rules
+    void Query(float l, float t, float r, float b, UINT layers,
+               vector<LPGAMEOBJECT> &result, vector<int> &found) const;
+
+    size_t GetSize() { return ids.size(); }
+    void GetTileCount(int &columns, int &rows) {
+        columns = this->columns;
+        rows = this->rows;
+    }
+    bool IsDirty() { return isDirty; }
+};
+
+typedef CStaticLayer *LPSTATICLAYER;
@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "GameObject.hpp"
+#include "SweepAndPrune.hpp"
+
+void CSweepAndPrune::Swap(int i, int j) {
+    std::swap(sorted[i], sorted[j]);
+    entries[sorted[i]].pos = i;
+    entries[sorted[j]].pos = j;
+}
+
+/*
+    Insertion sort step: move the entry at pos left or right until the order is restored
+*/
+void CSweepAndPrune::Resort(int pos) {
+    while (pos > 0 && entries[sorted[pos - 1]].l > entries[sorted[pos]].l) {
+        Swap(pos - 1, pos);
+        pos--;
+    }
+    while (pos + 1 < (int)sorted.size() && entries[sorted[pos + 1]].l < entries[sorted[pos]].l) {
+        Swap(pos, pos + 1);
+        pos++;
+    }
+}
+
+void CSweepAndPrune::Insert(LPGAMEOBJECT obj, DWORD dt) {
+    if (ids.find(obj) != ids.end()) {
+        Update(obj, dt);
+        return;
+    }
+
+    CSapEntry e;
+    e.obj = obj;
+    GetSweptBox(obj, dt, e.l, e.t, e.r, e.b);
+    e.pos = (int)sorted.size();
+    maxWidth = max(maxWidth, e.r - e.l);
+
+    int id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+        entries[id] = e;
+    } else {
+        id = (int)entries.size();
+        entries.push_back(e);
+    }
+    ids[obj] = id;
+    sorted.push_back(id);
+
+    Resort(e.pos);
+}
+
+void CSweepAndPrune::Update(LPGAMEOBJECT obj, DWORD dt) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    CSapEntry &e = entries[it->second];
+    GetSweptBox(obj, dt, e.l, e.t, e.r, e.b);
+    maxWidth = max(maxWidth, e.r - e.l);
+
+    Resort(e.pos);
+}
+
+void CSweepAndPrune::Remove(LPGAMEOBJECT obj) {
+    auto it = ids.find(obj);
+    if (it == ids.end())
+        return;
+
+    int id = it->second;
+    int pos = entries[id].pos;
+    sorted.erase(sorted.begin() + pos);
+    for (int i = pos; i < (int)sorted.size(); i++)
+        entries[sorted[i]].pos = i;
+
+    entries[id].obj = NULL;
+    ids.erase(it);
+    freeIds.push_back(id);
+}
+
+void CSweepAndPrune::Clear() {
+    entries.clear();
+    freeIds.clear();
+    ids.clear();
+    sorted.clear();
+    maxWidth = 0;
+}
+
+/*
+    Binary search the first box that may reach l, then walk right until boxes start past r
+*/
+void CSweepAndPrune::Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result, vector<int> &found) const {
+    found.clear();
+
+    float from = l - maxWidth;
+    int lo = 0, hi = (int)sorted.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (entries[sorted[mid]].l < from)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (int i = lo; i < (int)sorted.size(); i++) {
+        const CSapEntry &e = entries[sorted[i]];
+        if (e.l > r)
+            break;
+        if (e.r < l || e.b < t || e.t > b)
+            continue;
+        found.push_back(sorted[i]);
+    }
+
+    std::sort(found.begin(), found.end());
+    for (size_t i = 0; i < found.size(); i++)
+        result.push_back(entries[found[i]].obj);
+}
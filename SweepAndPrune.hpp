@@ -0,0 +1,49 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+
+#include "Broadphase.hpp"
+
+using namespace std;
+
+/*
+    Sweep and prune broadphase on the X axis
+
+    Tracked boxes are kept sorted by their left edge. Objects in a platformer move a few pixels
+    per frame, so the order barely changes between frames and an insertion sort step on Update
+    usually moves an entry by zero or one position.
+*/
+class CSweepAndPrune : public CBroadphase {
+    struct CSapEntry {
+        LPGAMEOBJECT obj;
+        float l, t, r, b; // swept box
+        int pos;          // index in sorted
+    };
+
+    vector<CSapEntry> entries;            // by entry id, obj NULL while free
+    vector<int> freeIds;                  // entry ids of removed objects, reused first
+    unordered_map<LPGAMEOBJECT, int> ids; // object -> entry id
+    vector<int> sorted;                   // live entry ids, sorted by l
+
+    float maxWidth; // widest box ever tracked, bounds how far left a query has to look
+
+    void Swap(int i, int j);
+    void Resort(int pos);
+
+public:
+    CSweepAndPrune() { maxWidth = 0; }
+
+    virtual void Insert(LPGAMEOBJECT obj, DWORD dt = 0);
+    virtual void Update(LPGAMEOBJECT obj, DWORD dt);
+    virtual void Remove(LPGAMEOBJECT obj);
+    virtual void Clear();
+
+    using CBroadphase::Query;
+    virtual void Query(float l, float t, float r, float b, vector<LPGAMEOBJECT> &result, vector<int> &found) const;
+
+    virtual size_t GetSize() { return ids.size(); }
+};
+
+typedef CSweepAndPrune *LPSWEEPANDPRUNE;
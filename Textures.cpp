@@ -2,7 +2,7 @@
 
 #include "Game.hpp"
 #include "debug.hpp"
-#include "textures.hpp"
+#include "Textures.hpp"
 
 CTextures *CTextures::__instance = NULL;
 
@@ -19,12 +19,17 @@ void CTextures::Add(int id, LPCWSTR filePath) {
     textures[id] = CGame::GetInstance()->LoadTexture(filePath);
 }
 
+/*
+    Read only, so that scenes loading in the background can look textures up too
+*/
 LPTEXTURE CTextures::Get(unsigned int i) {
-    LPTEXTURE t = textures[i];
-    if (t == NULL)
+    auto it = textures.find(i);
+    if (it == textures.end()) {
         DebugOut(L"[ERROR] Texture Id %d not found !\n", i);
+        return NULL;
+    }
 
-    return t;
+    return it->second; // NULL when headless, see CGame::LoadTexture
 }
 
 /*
@@ -33,6 +33,19 @@ wstring ToWSTR(string st) {
     return wstr;
 }
 
+/*
+    wchar_t* string to char* string.
+*/
+string ToSTR(wstring wst) {
+    size_t size = wcstombs(NULL, wst.c_str(), 0);
+    if (size == (size_t)-1)
+        return "";
+
+    string st(size, '\0');
+    wcstombs(&st[0], wst.c_str(), size);
+    return st;
+}
+
 /*
     Convert char* string to wchar_t* string.
 */
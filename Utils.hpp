@@ -5,6 +5,7 @@
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <ios>
 #include <string>
 #include <ctime>
 #include <stdarg.h>
@@ -16,3 +17,16 @@ vector<string> split(string line, string delimeter = "\t");
 wstring ToWSTR(string st);
 
 LPCWSTR ToLPCWSTR(string st);
+string ToSTR(wstring wst);
+
+/*
+    Open a file stream by a wide path: the MSVC library takes it as is, the others only take
+    narrow paths
+*/
+template <class TStream> void OpenFile(TStream &f, LPCWSTR path, ios_base::openmode mode = ios_base::openmode()) {
+#if defined(_MSC_VER)
+    f.open(path, mode);
+#else
+    f.open(ToSTR(path), mode);
+#endif
+}
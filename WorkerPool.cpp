@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include "WorkerPool.hpp"
+
+CWorkerPool *CWorkerPool::__instance = NULL;
+
+CWorkerPool *CWorkerPool::GetInstance() {
+    if (__instance == NULL)
+        __instance = new CWorkerPool();
+    return __instance;
+}
+
+CWorkerPool::CWorkerPool(int threadCount) {
+    generation = 0;
+    busy = 0;
+    quit = false;
+    job = NULL;
+    count = grain = 0;
+    next = 0;
+
+    if (threadCount < 0)
+        threadCount = max(0, (int)thread::hardware_concurrency() - 1);
+
+    for (int i = 0; i < threadCount; i++)
+        threads.push_back(thread(&CWorkerPool::WorkerMain, this, i + 1));
+}
+
+CWorkerPool::~CWorkerPool() {
+    {
+        unique_lock<mutex> l(lock);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+void CWorkerPool::RunChunks(int worker) {
+    while (true) {
+        size_t begin = next.fetch_add(grain);
+        if (begin >= count)
+            return;
+        (*job)(begin, min(begin + grain, count), worker);
+    }
+}
+
+void CWorkerPool::WorkerMain(int worker) {
+    UINT seen = 0;
+
+    while (true) {
+        {
+            unique_lock<mutex> l(lock);
+            wake.wait(l, [&] { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+        }
+
+        RunChunks(worker);
+
+        unique_lock<mutex> l(lock);
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
+
+void CWorkerPool::ParallelFor(size_t count, size_t grain, const WORKERJOB &job) {
+    if (count == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    // not worth waking anybody up
+    if (threads.empty() || count <= grain) {
+        job(0, count, 0);
+        return;
+    }
+
+    {
+        unique_lock<mutex> l(lock);
+        this->job = &job;
+        this->count = count;
+        this->grain = grain;
+        next = 0;
+        busy = (int)threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    RunChunks(0);
+
+    // every worker has to check in, even those that found no chunk left, before job goes away
+    unique_lock<mutex> l(lock);
+    done.wait(l, [&] { return busy == 0; });
+    this->job = NULL;
+}
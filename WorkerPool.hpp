@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <windows.h>
+
+using namespace std;
+
+// Job run by ParallelFor on items [begin, end), worker is 0 for the calling thread
+typedef function<void(size_t begin, size_t end, int worker)> WORKERJOB;
+
+/*
+    Fixed set of worker threads sleeping until ParallelFor hands them work
+
+    The calling thread takes part in the work too, so GetWorkerCount() is the number of threads
+    plus one. Items are handed out in chunks of grain through an atomic counter
+*/
+class CWorkerPool {
+    static CWorkerPool *__instance;
+
+    vector<thread> threads;
+
+    mutex lock;
+    condition_variable wake; // signaled when a new job starts or the pool shuts down
+    condition_variable done; // signaled when the last worker finished the current job
+    UINT generation;         // id of the current job, workers wait for it to change
+    int busy;                // workers still running the current job
+    bool quit;
+
+    const WORKERJOB *job;
+    size_t count;
+    size_t grain;
+    atomic<size_t> next;
+
+    void WorkerMain(int worker);
+    void RunChunks(int worker);
+
+public:
+    // threadCount < 0: one thread per extra hardware core
+    CWorkerPool(int threadCount = -1);
+    ~CWorkerPool();
+
+    int GetWorkerCount() { return (int)threads.size() + 1; }
+
+    // Run job over [0, count) and wait until every item is done
+    void ParallelFor(size_t count, size_t grain, const WORKERJOB &job);
+
+    static CWorkerPool *GetInstance();
+};
+
+typedef CWorkerPool *LPWORKERPOOL;
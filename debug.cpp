@@ -1,7 +1,9 @@
 #include "debug.hpp"
+#include <cwchar>
 #include <windows.h>
 
 HWND _hwnd = NULL;
+bool _isConsole = false;
 
 void DebugOut(const wchar_t *fmt, ...) {
     va_list argp;
@@ -10,6 +12,10 @@ void DebugOut(const wchar_t *fmt, ...) {
     vswprintf_s(dbg_out, fmt, argp);
     va_end(argp);
     OutputDebugString(dbg_out);
+    if (_isConsole) {
+        fputws(dbg_out, stdout);
+        fflush(stdout);
+    }
 }
 
 void DebugOutTitle(const wchar_t *fmt, ...) {
@@ -21,3 +27,7 @@ void DebugOutTitle(const wchar_t *fmt, ...) {
 void SetDebugWindow(HWND hwnd) {
     _hwnd = hwnd;
 }
+
+void SetDebugConsole(bool isConsole) {
+    _isConsole = isConsole;
+}
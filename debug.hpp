@@ -22,3 +22,6 @@
 void DebugOut(const wchar_t *fmt, ...);
 void DebugOutTitle(const wchar_t *fmt, ...);
 void SetDebugWindow(HWND hwnd);
+
+// Console tools also see DebugOut on stdout
+void SetDebugConsole(bool isConsole);
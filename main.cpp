@@ -23,6 +23,8 @@ HOW TO INSTALL Microsoft.DXSDK.D3DX
 
 #include <d3d10.h>
 #include <d3dx10.h>
+#include <cstdlib>
+#include <cstring>
 #include <list>
 #include <windows.h>
 
@@ -30,7 +32,11 @@ HOW TO INSTALL Microsoft.DXSDK.D3DX
 #include "Animations.hpp"
 #include "Game.hpp"
 #include "GameObject.hpp"
+#include "Headless.hpp"
+#include "InputRecording.hpp"
+#include "PlayScene.hpp"
 #include "Textures.hpp"
+#include "Utils.hpp"
 #include "debug.hpp"
 
 #include "Brick.hpp"
@@ -52,6 +58,13 @@ HOW TO INSTALL Microsoft.DXSDK.D3DX
 #define SCREEN_WIDTH 320
 #define SCREEN_HEIGHT 240
 
+// After a stall, at most this many steps are simulated in one frame and the rest of the delay is
+// dropped, so that a slow frame never leads to even more work on the next one
+#define MAX_CATCHUP_STEPS 5
+
+// -record / -replay: the session recorded or replayed, see Run
+CInputRecording recording;
+
 LRESULT CALLBACK WinProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
     switch (message) {
     case WM_DESTROY:
@@ -65,8 +78,8 @@ LRESULT CALLBACK WinProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 }
 
 /*
-    Update world status for this frame
-    dt: time period between beginning of last frame and beginning of this frame
+    Update world status by one simulation step
+    dt: always SIMULATION_STEP, see Run
 */
 void Update(DWORD dt) {
     CGame::GetInstance()->GetCurrentScene()->Update(dt);
@@ -146,6 +159,7 @@ int Run() {
     int done = 0;
     ULONGLONG frameStart = GetTickCount64();
     DWORD tickPerFrame = 1000 / MAX_FRAME_RATE;
+    DWORD lag = 0; // time not simulated yet
 
     while (!done) {
         if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
@@ -164,12 +178,39 @@ int Run() {
 
         if (dt >= tickPerFrame) {
             frameStart = now;
-
-            CGame::GetInstance()->ProcessKeyboard();
-            Update(dt);
+            lag += dt;
+
+            LPGAME game = CGame::GetInstance();
+            game->ProcessKeyboard();
+
+            int steps = 0;
+            if (game->IsReplaying()) {
+                // the steps of the recorded frame, so the replay does not depend on timing
+                for (; steps < recording.GetFrameSteps(); steps++)
+                    Update(SIMULATION_STEP);
+                lag = 0;
+            } else {
+                while (lag >= SIMULATION_STEP && steps < MAX_CATCHUP_STEPS) {
+                    Update(SIMULATION_STEP);
+                    lag -= SIMULATION_STEP;
+                    steps++;
+                }
+                if (lag >= SIMULATION_STEP)
+                    lag %= SIMULATION_STEP;
+            }
+            game->RecordFrame(steps);
+
+            // once replayed, the game goes on with the keyboard
+            if (game->IsReplaying() && recording.IsReplayDone()) {
+                recording.Report();
+                game->SetInputRecording(NULL, false);
+            }
+
+            // blend the last two steps by how far we already are into the next one
+            game->SetRenderAlpha((float)lag / SIMULATION_STEP);
             Render();
 
-            CGame::GetInstance()->SwitchScene();
+            game->SwitchScene();
         } else
             Sleep(tickPerFrame - dt);
     }
@@ -177,11 +218,43 @@ int Run() {
     return 1;
 }
 
+/*
+    The word after option on the command line, empty without one
+*/
+string GetOptionValue(LPSTR cmdLine, const char *option) {
+    const char *p = strstr(cmdLine, option);
+    if (p == NULL)
+        return "";
+    p += strlen(option);
+    while (*p == ' ')
+        p++;
+    const char *end = p;
+    while (*end != '\0' && *end != ' ')
+        end++;
+    return string(p, end);
+}
+
 int WINAPI WinMain(
     _In_ HINSTANCE hInstance,
     _In_opt_ HINSTANCE hPrevInstance,
     _In_ LPSTR lpCmdLine,
     _In_ int nCmdShow) {
+    // -record file: record the keyboard of the session into file, to play it again with -replay
+    // -replay file: play a recorded session, then go on with the keyboard
+    wstring recordPath = ToWSTR(GetOptionValue(lpCmdLine, "-record"));
+    wstring replayPath = ToWSTR(GetOptionValue(lpCmdLine, "-replay"));
+
+    // -headless [scene id]: simulate without window as fast as possible, see RunHeadless
+    // -headless -replay file: check a recording without window, see RunReplay
+    const char *headless = strstr(lpCmdLine, "-headless");
+    if (headless != NULL && !replayPath.empty())
+        return RunReplay(GAME_FILE, replayPath.c_str());
+    if (headless != NULL) {
+        char *end;
+        long scene = strtol(headless + strlen("-headless"), &end, 10);
+        return RunHeadless(GAME_FILE, end != headless + strlen("-headless") ? (int)scene : -1);
+    }
+
     HWND hWnd = CreateGameWindow(hInstance, nCmdShow, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     SetDebugWindow(hWnd);
@@ -190,12 +263,24 @@ int WINAPI WinMain(
     game->Init(hWnd, hInstance);
     game->InitKeyboard();
 
-    // IMPORTANT: this is the only place where a hardcoded file name is allowed !
-    game->Load(L"mario-sample.txt");
+    if (!replayPath.empty() && recording.Load(replayPath.c_str()))
+        game->SetInputRecording(&recording, true);
+
+    game->Load(GAME_FILE);
+
+    if (game->IsReplaying() && !game->StartReplay(&recording))
+        game->SetInputRecording(NULL, false);
+    else if (!game->IsReplaying() && !recordPath.empty()) {
+        recording.Begin((LPPLAYSCENE)game->GetCurrentScene());
+        game->SetInputRecording(&recording, false);
+    }
 
     SetWindowPos(hWnd, 0, 0, 0, SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2, SWP_NOMOVE | SWP_NOOWNERZORDER | SWP_NOZORDER);
 
     Run();
 
+    if (!recordPath.empty() && game->GetInputRecording() == &recording && !game->IsReplaying())
+        recording.Save(recordPath.c_str());
+
     return 0;
 }
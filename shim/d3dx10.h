@@ -0,0 +1,82 @@
+#pragma once
+/*
+    The Direct3D 10 types the sprites and textures hold, for the builds that are not on Windows.
+    There is never a device there (see GameHeadless.cpp), so nothing is drawn
+*/
+#include <windows.h>
+
+struct D3DXVECTOR2 {
+    float x, y;
+};
+
+struct D3DXVECTOR3 {
+    float x, y, z;
+    D3DXVECTOR3() {}
+    D3DXVECTOR3(float x, float y, float z) : x(x), y(y), z(z) {}
+};
+
+struct D3DXCOLOR {
+    float r, g, b, a;
+    D3DXCOLOR() {}
+    D3DXCOLOR(float r, float g, float b, float a) : r(r), g(g), b(b), a(a) {}
+};
+
+struct D3DXMATRIX {
+    float m[16];
+    D3DXMATRIX operator*(const D3DXMATRIX &) const { return *this; }
+};
+
+inline D3DXMATRIX *D3DXMatrixScaling(D3DXMATRIX *out, float, float, float) {
+    return out;
+}
+
+inline D3DXMATRIX *D3DXMatrixTranslation(D3DXMATRIX *out, float, float, float) {
+    return out;
+}
+
+struct ID3D10ShaderResourceView {
+    void Release() {}
+};
+
+struct D3D10_TEXTURE2D_DESC {
+    UINT Width, Height;
+};
+
+struct ID3D10Texture2D {
+    void GetDesc(D3D10_TEXTURE2D_DESC *) {}
+    void Release() {}
+};
+
+struct D3DX10_SPRITE {
+    D3DXMATRIX matWorld;
+    D3DXVECTOR2 TexCoord, TexSize;
+    D3DXCOLOR ColorModulate;
+    ID3D10ShaderResourceView *pTexture;
+    UINT TextureIndex;
+};
+
+struct ID3DX10Sprite {
+    HRESULT DrawSpritesImmediate(D3DX10_SPRITE *, UINT, UINT, UINT) { return S_OK; }
+    void Release() {}
+};
+typedef ID3DX10Sprite *LPD3DX10SPRITE;
+
+struct ID3D10Device {
+    void Release() {}
+};
+
+struct IDXGISwapChain {
+    void Release() {}
+};
+
+struct ID3D10RenderTargetView {
+    void Release() {}
+};
+
+struct ID3D10BlendState {
+    void Release() {}
+};
+
+struct ID3D10SamplerState {
+    void Release() {}
+};
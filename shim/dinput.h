@@ -0,0 +1,28 @@
+#pragma once
+/*
+    The DirectInput types and key codes the key handlers and input recordings use, for the
+    builds that are not on Windows, where keys only come from a recording being replayed
+*/
+#include <windows.h>
+
+struct DIDEVICEOBJECTDATA {
+    DWORD dwOfs;
+    DWORD dwData;
+};
+
+struct IDirectInput8 {};
+typedef IDirectInput8 *LPDIRECTINPUT8;
+
+struct IDirectInputDevice8 {};
+typedef IDirectInputDevice8 *LPDIRECTINPUTDEVICE8;
+
+#define DIK_1 0x02
+#define DIK_2 0x03
+#define DIK_0 0x0B
+#define DIK_BACK 0x0E
+#define DIK_R 0x13
+#define DIK_A 0x1E
+#define DIK_S 0x1F
+#define DIK_LEFT 0xCB
+#define DIK_RIGHT 0xCD
+#define DIK_DOWN 0xD0
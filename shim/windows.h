@@ -0,0 +1,140 @@
+#pragma once
+/*
+    The part of the Win32 API the simulation uses, for the builds that are not on Windows (see
+    CMakeLists.txt). Only types and what a console tool needs: no window, no debugger output
+*/
+#include <cfloat>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <string>
+
+typedef uint32_t DWORD;
+typedef uint64_t ULONGLONG;
+typedef unsigned char BYTE;
+typedef unsigned char BOOLEAN;
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef long HRESULT;
+typedef float FLOAT;
+typedef void VOID;
+typedef void *LPVOID;
+typedef unsigned long long UINT64;
+typedef wchar_t WCHAR;
+typedef const wchar_t *LPCWSTR;
+typedef wchar_t *LPWSTR;
+typedef char *LPSTR;
+typedef void *HWND;
+typedef void *HINSTANCE;
+typedef void *HICON;
+typedef void *HBRUSH;
+typedef intptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef void *WNDPROC;
+
+struct RECT {
+    long left, top, right, bottom;
+};
+
+struct MSG {
+    UINT message;
+};
+
+#define TRUE 1
+#define FALSE 0
+#define S_OK 0
+#define FAILED(hr) ((hr) < 0)
+#define MAX_PATH 260
+#define CALLBACK
+#define WINAPI
+#define _In_
+#define _In_opt_
+#define _TRUNCATE ((size_t)-1)
+#define __uuidof(x) 0
+
+inline ULONGLONG GetTickCount64() {
+    return (ULONGLONG)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+inline void OutputDebugString(LPCWSTR) {
+}
+
+inline BOOL SetWindowText(HWND, LPCWSTR) {
+    return TRUE;
+}
+
+inline void Sleep(DWORD) {
+}
+
+inline void ZeroMemory(void *p, size_t size) {
+    memset(p, 0, size);
+}
+
+/*
+    Length of the path, 0 on failure, as GetTempPathW. The path ends with a slash
+*/
+inline DWORD GetTempPathW(DWORD size, LPWSTR path) {
+    const char *dir = getenv("TMPDIR");
+    std::string s = dir != NULL && dir[0] != '\0' ? dir : "/tmp";
+    if (s.back() != '/')
+        s += '/';
+    if (s.size() + 1 > size)
+        return 0;
+    mbstowcs(path, s.c_str(), size);
+    return (DWORD)s.size();
+}
+
+/*
+    Create a new empty file <path><prefix>XXXXXX.tmp and put its name in tempFile (MAX_PATH
+    characters), as GetTempFileNameW with unique 0
+*/
+inline UINT GetTempFileNameW(LPCWSTR path, LPCWSTR prefix, UINT unique, LPWSTR tempFile) {
+    char name[MAX_PATH];
+    if (snprintf(name, MAX_PATH, "%ls%lsXXXXXX.tmp", path, prefix) >= MAX_PATH)
+        return 0;
+    int fd = mkstemps(name, 4);
+    if (fd < 0)
+        return 0;
+    fclose(fdopen(fd, "w"));
+    mbstowcs(tempFile, name, MAX_PATH);
+    return 1;
+}
+
+inline BOOL DeleteFileW(LPCWSTR path) {
+    char name[MAX_PATH];
+    if (wcstombs(name, path, MAX_PATH) >= MAX_PATH)
+        return FALSE;
+    return remove(name) == 0 ? TRUE : FALSE;
+}
+
+/*
+    As MSVC, %s and %c of a wide format take wide strings and characters: they are made %ls and
+    %lc for the C library
+*/
+template <size_t N> int vswprintf_s(wchar_t (&buffer)[N], const wchar_t *fmt, va_list argp) {
+    std::wstring format;
+    for (const wchar_t *p = fmt; *p != L'\0'; p++) {
+        format += *p;
+        if (*p != L'%')
+            continue;
+        while (p[1] != L'\0' && wcschr(L"-+ #0123456789.*", p[1]) != NULL)
+            format += *++p;
+        if (p[1] == L's' || p[1] == L'c')
+            format += L'l';
+        if (p[1] != L'\0')
+            format += *++p;
+    }
+    return vswprintf(buffer, N, format.c_str(), argp);
+}
+
+inline int mbstowcs_s(size_t *converted, wchar_t *dst, size_t size, const char *src, size_t) {
+    *converted = mbstowcs(dst, src, size) + 1;
+    return 0;
+}
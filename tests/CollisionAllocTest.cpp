@@ -0,0 +1,141 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Brick.hpp"
+#include "Collision.hpp"
+#include "Goomba.hpp"
+#include "SpatialGrid.hpp"
+#include "StaticLayer.hpp"
+#include "debug.hpp"
+
+#define ALLOC_TEST_WARMUP_FRAMES 5000 // goombas walk the whole world, so every grid cell has grown
+#define ALLOC_TEST_FRAMES 10000
+#define ALLOC_TEST_STEP 10
+#define ALLOC_TEST_COLUMNS 64
+#define ALLOC_TEST_GOOMBAS 100
+#define ALLOC_TEST_FLOOR_Y 400.0f
+
+/*
+    Once warmed up, a busy collision world runs ALLOC_TEST_FRAMES frames (broadphase upkeep and
+    the Update, so Process, of every object, as CCollisionBench does) without a single call to
+    operator new: events come from the event arena (see CCollisionEventArena), and the cells of
+    the spatial grid keep their capacity once grown
+*/
+
+static std::atomic<bool> isCounting(false);
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+    if (isCounting)
+        allocations++;
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+    if (isCounting)
+        allocations++;
+    size_t alignment = (size_t)align;
+    void *p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+static float RandomFloat(float a, float b) {
+    return a + (b - a) * (rand() / (float)RAND_MAX);
+}
+
+int main() {
+    SetDebugConsole(true);
+    srand(1);
+
+    // a floor closed by two walls, so the goombas keep walking into bricks and each other
+    vector<LPGAMEOBJECT> objects;
+    for (int i = 0; i < ALLOC_TEST_COLUMNS; i++)
+        objects.push_back(new CBrick(i * 16.0f, ALLOC_TEST_FLOOR_Y));
+    for (int i = 1; i <= 8; i++) {
+        objects.push_back(new CBrick(0, ALLOC_TEST_FLOOR_Y - 16.0f * i));
+        objects.push_back(new CBrick((ALLOC_TEST_COLUMNS - 1) * 16.0f, ALLOC_TEST_FLOOR_Y - 16.0f * i));
+    }
+    for (int i = 0; i < ALLOC_TEST_GOOMBAS; i++) {
+        LPGAMEOBJECT goomba = new CGoomba(RandomFloat(32, (ALLOC_TEST_COLUMNS - 3) * 16.0f), RandomFloat(200, 350));
+        goomba->SetSpeed(rand() % 2 ? GOOMBA_WALKING_SPEED : -GOOMBA_WALKING_SPEED, 0);
+        objects.push_back(goomba);
+    }
+
+    CSpatialGrid grid;
+    CStaticLayer staticLayer;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i]->IsStatic())
+            staticLayer.Add(objects[i]);
+        else
+            grid.Insert(objects[i]);
+    }
+    staticLayer.Build();
+
+    CCollision *collision = CCollision::GetInstance();
+    collision->SetBroadphase(&grid);
+    collision->SetStaticLayer(&staticLayer);
+    collision->ResetPairStats();
+
+    for (int f = 0; f < ALLOC_TEST_WARMUP_FRAMES + ALLOC_TEST_FRAMES; f++) {
+        if (f == ALLOC_TEST_WARMUP_FRAMES)
+            isCounting = true;
+
+        for (size_t i = 0; i < objects.size(); i++) {
+            objects[i]->Update(ALLOC_TEST_STEP, &objects);
+            if (!objects[i]->IsStatic())
+                grid.Update(objects[i], ALLOC_TEST_STEP);
+        }
+        collision->ResetEvents();
+    }
+    isCounting = false;
+
+    size_t tested, rejected;
+    collision->GetPairStats(tested, rejected);
+    collision->SetBroadphase(NULL);
+    collision->SetStaticLayer(NULL);
+    for (size_t i = 0; i < objects.size(); i++)
+        delete objects[i];
+
+    DebugOut(L"[TEST] %d frames, %d pairs swept: %d calls to operator new\n", ALLOC_TEST_FRAMES, (int)tested,
+             (int)allocations);
+    if (tested == 0) {
+        DebugOut(L"[ERROR] No pair was swept, the world is not busy\n");
+        return 1;
+    }
+    return allocations == 0 ? 0 : 1;
+}
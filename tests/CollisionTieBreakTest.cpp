@@ -0,0 +1,78 @@
+#include <vector>
+
+#include "Brick.hpp"
+#include "Collision.hpp"
+#include "Goomba.hpp"
+#include "Mario.hpp"
+#include "StaticLayer.hpp"
+#include "debug.hpp"
+
+#define TIE_BREAK_TEST_STEP 10
+#define TIE_BREAK_TEST_SPEED 1.0f // 10 pixels per step
+#define TIE_BREAK_TEST_GAP 4.0f   // so both are hit at t 0.4
+
+/*
+    A goomba walks right into a brick and a Mario whose left edges are at the same x, so both
+    events have the same t and Filter keeps the first. Mario comes first in coObjects.
+
+    Without a static layer, events follow coObjects and Mario wins. With the brick in the static
+    layer its events come before those of the moving objects (see CCollision::Scan) and the brick
+    wins
+*/
+
+static LPGAMEOBJECT FirstHitOnX(LPGAMEOBJECT mover, vector<LPGAMEOBJECT> &coObjects) {
+    CCollision *collision = CCollision::GetInstance();
+    vector<LPCOLLISIONEVENT> coEvents;
+    collision->Scan(mover, TIE_BREAK_TEST_STEP, &coObjects, coEvents);
+
+    LPCOLLISIONEVENT colX = NULL, colY = NULL;
+    collision->Filter(mover, coEvents, colX, colY, 0, 1, 0);
+    LPGAMEOBJECT hit = colX != NULL ? colX->obj : NULL;
+    collision->ResetEvents();
+    return hit;
+}
+
+static const wchar_t *GetName(LPGAMEOBJECT obj, LPGAMEOBJECT brick, LPGAMEOBJECT mario) {
+    return obj == brick ? L"the brick" : obj == mario ? L"Mario" : L"nothing";
+}
+
+int main() {
+    SetDebugConsole(true);
+
+    CGoomba goomba(100, 100);
+    goomba.SetSpeed(TIE_BREAK_TEST_SPEED, 0);
+    float l, t, r, b;
+    goomba.GetCachedBoundingBox(l, t, r, b);
+
+    // left edges of both at r + TIE_BREAK_TEST_GAP
+    CBrick brick(0, 100);
+    float bl, bt, br, bb;
+    brick.GetCachedBoundingBox(bl, bt, br, bb);
+    brick.SetPosition(r + TIE_BREAK_TEST_GAP - bl, 100);
+
+    CMario mario(0, 100);
+    float ml, mt, mr, mb;
+    mario.GetCachedBoundingBox(ml, mt, mr, mb);
+    mario.SetPosition(r + TIE_BREAK_TEST_GAP - ml, 100);
+    mario.SetSpeed(0, 0);
+
+    vector<LPGAMEOBJECT> coObjects;
+    coObjects.push_back(&mario);
+    coObjects.push_back(&brick);
+
+    CCollision *collision = CCollision::GetInstance();
+    collision->SetBroadphase(NULL);
+    collision->SetStaticLayer(NULL);
+    LPGAMEOBJECT withoutLayer = FirstHitOnX(&goomba, coObjects);
+
+    CStaticLayer staticLayer;
+    staticLayer.Add(&brick);
+    staticLayer.Build();
+    collision->SetStaticLayer(&staticLayer);
+    LPGAMEOBJECT withLayer = FirstHitOnX(&goomba, coObjects);
+    collision->SetStaticLayer(NULL);
+
+    DebugOut(L"[TEST] Tie on X: %s wins without the static layer, %s with it\n",
+             GetName(withoutLayer, &brick, &mario), GetName(withLayer, &brick, &mario));
+    return withoutLayer == &mario && withLayer == &brick ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include <cstring>
+
+#include "Game.hpp"
+#include "Headless.hpp"
+#include "InputRecording.hpp"
+#include "PlayScene.hpp"
+#include "debug.hpp"
+
+#define REPLAY_TEST_SCENE 1
+#define REPLAY_TEST_FRAMES 400
+#define REPLAY_TEST_MAX_STEPS 3 // steps per frame go 1, 2, ... up to this, as with a varying frame rate
+
+/*
+    A headless play session driven by a made-up keyboard is recorded, then replayed: every frame
+    of the replay must end in the state hash recorded for it. Run from the directory of the game
+    file
+*/
+
+static const int keys[] = {DIK_RIGHT, DIK_LEFT, DIK_A, DIK_S, DIK_DOWN};
+
+// Whether key is held in frame: walk right, run, jump now and then, turn back, sit
+static bool IsHeld(int key, int frame) {
+    switch (key) {
+    case DIK_RIGHT:
+        return frame < 250;
+    case DIK_LEFT:
+        return frame >= 250 && frame < 330;
+    case DIK_A:
+        return frame >= 80 && frame < 200;
+    case DIK_S:
+        return frame % 60 >= 30 && frame % 60 < 45;
+    case DIK_DOWN:
+        return frame >= 350 && frame < 370;
+    }
+    return false;
+}
+
+// The keyboard of frame: states of the keys, and an event for each key that changed since the last frame
+static DWORD ReadKeyboard(int frame, BYTE *states, DIDEVICEOBJECTDATA *events) {
+    DWORD count = 0;
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        bool isHeld = IsHeld(keys[i], frame);
+        states[keys[i]] = isHeld ? 0x80 : 0;
+        if (isHeld != (frame > 0 && IsHeld(keys[i], frame - 1))) {
+            events[count].dwOfs = keys[i];
+            events[count].dwData = states[keys[i]];
+            count++;
+        }
+    }
+    return count;
+}
+
+static int GetFrameSteps(int frame) {
+    return frame % REPLAY_TEST_MAX_STEPS + 1;
+}
+
+int main() {
+    SetDebugConsole(true);
+    static CInputRecording recording;
+
+    LPGAME game = CGame::GetInstance();
+    game->InitHeadless(HEADLESS_VIEW_WIDTH, HEADLESS_VIEW_HEIGHT);
+    game->Load(GAME_FILE);
+    if (!game->HasScene(REPLAY_TEST_SCENE)) {
+        DebugOut(L"[ERROR] The game has no scene %d\n", REPLAY_TEST_SCENE);
+        return 1;
+    }
+    game->InitiateSwitchScene(REPLAY_TEST_SCENE);
+    game->SwitchScene();
+
+    LPPLAYSCENE scene = (LPPLAYSCENE)game->GetCurrentScene();
+    float startX, startY;
+    scene->GetPlayer()->GetPosition(startX, startY);
+
+    recording.Begin(scene);
+    game->SetInputRecording(&recording, false);
+
+    BYTE states[KEYBOARD_STATE_SIZE];
+    DIDEVICEOBJECTDATA events[KEYBOARD_BUFFER_SIZE];
+    memset(states, 0, sizeof(states));
+    for (int f = 0; f < REPLAY_TEST_FRAMES; f++) {
+        DWORD count = ReadKeyboard(f, states, events);
+        game->ProcessKeyboard(states, events, count);
+        for (int i = 0; i < GetFrameSteps(f); i++)
+            game->GetCurrentScene()->Update(SIMULATION_STEP);
+        game->RecordFrame(GetFrameSteps(f));
+        game->SwitchScene();
+    }
+
+    // the keys have to have moved Mario, or the replay would check nothing
+    float x, y;
+    ((LPPLAYSCENE)game->GetCurrentScene())->GetPlayer()->GetPosition(x, y);
+    bool isMoved = x != startX;
+
+    if (!game->StartReplay(&recording))
+        return 1;
+    while (!recording.IsReplayDone()) {
+        game->ProcessKeyboard();
+        for (int i = 0; i < recording.GetFrameSteps(); i++)
+            game->GetCurrentScene()->Update(SIMULATION_STEP);
+        game->RecordFrame(recording.GetFrameSteps());
+        game->SwitchScene();
+    }
+    recording.Report();
+
+    bool isPassed = isMoved && recording.GetReplayedFrameCount() == REPLAY_TEST_FRAMES &&
+                    recording.GetMismatchCount() == 0;
+    DebugOut(L"[TEST] %d frames recorded and replayed, Mario %s, %d mismatches\n", (int)recording.GetFrameCount(),
+             isMoved ? L"moved" : L"DID NOT MOVE", (int)recording.GetMismatchCount());
+    return isPassed ? 0 : 1;
+}
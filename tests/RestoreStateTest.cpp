@@ -0,0 +1,121 @@
+#include <cstring>
+#include <vector>
+
+#include "Game.hpp"
+#include "Headless.hpp"
+#include "PlayScene.hpp"
+#include "SaveState.hpp"
+#include "debug.hpp"
+
+#define RESTORE_TEST_SCENE 1
+#define RESTORE_TEST_FRAMES 100 // before the save, so that objects have moved, fallen and landed
+#define RESTORE_TEST_HEADER_SIZE (6 * sizeof(UINT)) // see CPlayScene::SaveState
+#define RESTORE_TEST_BAD_TYPE 99
+
+/*
+    CPlayScene::RestoreState refuses broken save states without changing the scene: after each of
+    them the state hash is the same as before. Then the save state they were made from is still
+    restored, and the frames after it are the same each time it is. Run from the directory of the
+    game file
+*/
+
+static UINT ReadUint(const vector<BYTE> &data, size_t position) {
+    UINT value;
+    memcpy(&value, &data[position], sizeof(UINT));
+    return value;
+}
+
+static void WriteInt(vector<BYTE> &data, size_t position, int value) {
+    memcpy(&data[position], &value, sizeof(int));
+}
+
+// The first size bytes of data, with the size in its header fixed, so that only the records are short
+static vector<BYTE> Truncate(const vector<BYTE> &data, size_t size) {
+    vector<BYTE> truncated(data.begin(), data.begin() + size);
+    WriteInt(truncated, 2 * sizeof(UINT), (int)size);
+    return truncated;
+}
+
+static bool IsRefused(LPPLAYSCENE scene, const vector<BYTE> &data, const wchar_t *name) {
+    UINT64 hash = scene->GetStateHash();
+    bool isRestored = scene->RestoreState(data);
+    bool isUnchanged = scene->GetStateHash() == hash;
+
+    DebugOut(L"[TEST] %s: %s, scene %s\n", name, isRestored ? L"restored" : L"refused",
+             isUnchanged ? L"unchanged" : L"CHANGED");
+    return !isRestored && isUnchanged;
+}
+
+static UINT64 StepAndHash(LPPLAYSCENE scene) {
+    for (int i = 0; i < RESTORE_TEST_FRAMES; i++)
+        scene->Update(SIMULATION_STEP);
+    return scene->GetStateHash();
+}
+
+int main() {
+    SetDebugConsole(true);
+
+    LPGAME game = CGame::GetInstance();
+    game->InitHeadless(HEADLESS_VIEW_WIDTH, HEADLESS_VIEW_HEIGHT);
+    game->Load(GAME_FILE);
+    if (!game->HasScene(RESTORE_TEST_SCENE)) {
+        DebugOut(L"[ERROR] The game has no scene %d\n", RESTORE_TEST_SCENE);
+        return 1;
+    }
+    game->InitiateSwitchScene(RESTORE_TEST_SCENE);
+    game->SwitchScene();
+
+    LPPLAYSCENE scene = (LPPLAYSCENE)game->GetCurrentScene();
+    for (int i = 0; i < RESTORE_TEST_FRAMES; i++)
+        scene->Update(SIMULATION_STEP);
+
+    vector<BYTE> saved;
+    scene->SaveState(saved);
+    UINT64 savedHash = scene->GetStateHash();
+
+    // and away from it, so that a restore that went through would show
+    for (int i = 0; i < RESTORE_TEST_FRAMES; i++)
+        scene->Update(SIMULATION_STEP);
+
+    UINT count = ReadUint(saved, 3 * sizeof(UINT));
+    size_t firstRecord = RESTORE_TEST_HEADER_SIZE + count;
+    size_t secondRecord = firstRecord + sizeof(UINT) + ReadUint(saved, firstRecord) + sizeof(int);
+    if (count < 2 || secondRecord >= saved.size()) {
+        DebugOut(L"[ERROR] Scene %d has too few objects to test\n", RESTORE_TEST_SCENE);
+        return 1;
+    }
+
+    bool isPassed = true;
+    isPassed = IsRefused(scene, vector<BYTE>(saved.begin(), saved.begin() + saved.size() / 2), L"Truncated") &&
+               isPassed;
+    isPassed = IsRefused(scene, Truncate(saved, saved.size() / 2), L"Truncated among the objects") && isPassed;
+    isPassed = IsRefused(scene, Truncate(saved, saved.size() - 1), L"Truncated in the level stream") && isPassed;
+
+    vector<BYTE> broken = saved;
+    broken[firstRecord - 1] = RESTORE_TEST_BAD_TYPE;
+    isPassed = IsRefused(scene, broken, L"Unknown type of the last object") && isPassed;
+
+    broken = saved;
+    WriteInt(broken, RESTORE_TEST_HEADER_SIZE - sizeof(int), (int)count);
+    isPassed = IsRefused(scene, broken, L"Player out of range") && isPassed;
+
+    broken = saved;
+    WriteInt(broken, secondRecord - sizeof(int), (int)count);
+    isPassed = IsRefused(scene, broken, L"Ground out of range") && isPassed;
+
+    broken = saved;
+    WriteInt(broken, firstRecord, (int)saved.size());
+    isPassed = IsRefused(scene, broken, L"Object record past the end") && isPassed;
+
+    bool isRestored = scene->RestoreState(saved) && scene->GetStateHash() == savedHash;
+    DebugOut(L"[TEST] The save state itself: %s\n", isRestored ? L"restored" : L"NOT RESTORED");
+
+    // restored twice, the scene must reach the same state after the same frames
+    UINT64 firstRun = StepAndHash(scene);
+    isRestored = scene->RestoreState(saved) && isRestored;
+    UINT64 secondRun = StepAndHash(scene);
+    bool isDeterministic = firstRun == secondRun;
+    DebugOut(L"[TEST] %d frames after the save state, twice: %s\n", RESTORE_TEST_FRAMES,
+             isDeterministic ? L"same state" : L"DIFFERENT STATES");
+    return isPassed && isRestored && isDeterministic ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Brick.hpp"
+#include "Goomba.hpp"
+#include "SpatialGrid.hpp"
+#include "SpatialQuery.hpp"
+#include "StaticLayer.hpp"
+#include "debug.hpp"
+
+/*
+    Every CSpatialQuery query on a small world: a row of three bricks, [0, 16), [16, 32) and
+    [32, 48) along X, in the static layer, and a goomba at [96, 112) in the broadphase, all on the
+    same line. Edges are where the queries could disagree, so most checks sit right on them
+*/
+
+static int failures = 0;
+
+static void Check(bool isPassed, const wchar_t *name) {
+    if (!isPassed) {
+        DebugOut(L"[ERROR] %s\n", name);
+        failures++;
+    }
+}
+
+// Hit points come from x0 + dx * t and are off by rounding
+static bool IsNear(float value, float expected) {
+    return fabs(value - expected) < 0.001f;
+}
+
+static bool IsOnly(const vector<LPGAMEOBJECT> &result, LPGAMEOBJECT obj) {
+    return result.size() == 1 && result[0] == obj;
+}
+
+int main() {
+    SetDebugConsole(true);
+
+    CBrick first(8, 8), second(24, 8), third(40, 8);
+    CGoomba goomba(104, 8);
+
+    CStaticLayer staticLayer;
+    staticLayer.Add(&first);
+    staticLayer.Add(&second);
+    staticLayer.Add(&third);
+    staticLayer.Build();
+
+    CSpatialGrid grid;
+    grid.Insert(&goomba);
+
+    CSpatialQuery query;
+    query.SetSources(&grid, &staticLayer, NULL);
+
+    vector<LPGAMEOBJECT> result;
+
+    // Point: a shared edge belongs to the right box, the left edge of a box is in it, the right one is not
+    query.Point(16, 8, result);
+    Check(IsOnly(result, &second), L"Point on the edge shared by two bricks is not only in the right one");
+    query.Point(0, 8, result);
+    Check(IsOnly(result, &first), L"Point on the left edge of a brick is not in it");
+    query.Point(48, 8, result);
+    Check(result.empty(), L"Point on the right edge of a brick is in it");
+    query.Point(100, 8, result);
+    Check(IsOnly(result, &goomba), L"Point inside the goomba does not find it");
+
+    // Overlap: the same edges, with boxes on either side of them
+    query.Overlap(15.5f, 4, 16, 12, result);
+    Check(IsOnly(result, &first), L"Overlap left of the shared edge is not only in the left brick");
+    query.Overlap(16, 4, 16.5f, 12, result);
+    Check(IsOnly(result, &second), L"Overlap right of the shared edge is not only in the right brick");
+    query.Overlap(48, 0, 96, 16, result);
+    Check(result.empty(), L"Overlap only touching a brick and the goomba returns them");
+    query.Overlap(0, 0, 200, 16, result);
+    Check(result.size() == 4, L"Overlap of the whole row does not return all four objects");
+    query.Overlap(0, 0, 200, 16, result, COLLISION_LAYER_ENEMY);
+    Check(IsOnly(result, &goomba), L"Overlap does not keep to the given layers");
+    query.Overlap(0, 0, 200, 16, result, COLLISION_LAYER_ALL, &second);
+    Check(result.size() == 3 && find(result.begin(), result.end(), &second) == result.end(),
+          L"Overlap does not skip the ignored object");
+
+    // Raycast: along the row from the left, the first brick is hit on its left side
+    CSpatialHit hit;
+    bool isHit = query.Raycast(-10, 8, 200, 8, hit);
+    Check(isHit && hit.obj == &first && IsNear(hit.t, 10.0f / 210.0f) && hit.nx == -1 && hit.ny == 0 && IsNear(hit.x, 0),
+          L"Raycast along the row does not hit the first brick on its left side");
+    isHit = query.Raycast(-10, 8, 200, 8, hit, COLLISION_LAYER_ENEMY);
+    Check(isHit && hit.obj == &goomba && IsNear(hit.x, 96) && hit.nx == -1, L"Raycast on enemies does not hit the goomba");
+    isHit = query.Raycast(-10, 30, 200, 30, hit);
+    Check(!isHit, L"Raycast below the row hits something");
+
+    // SweepBox: a box falling onto the goomba lands on its top
+    float l, t, r, b;
+    goomba.GetCachedBoundingBox(l, t, r, b);
+    isHit = query.SweepBox(100, -20, 104, -10, 0, 20, hit);
+    Check(isHit && hit.obj == &goomba && IsNear(hit.t, (t + 10) / 20) && hit.ny == -1 && IsNear(hit.y, t - 10),
+          L"SweepBox falling onto the goomba does not land on its top");
+    isHit = query.SweepBox(100, -20, 104, -10, 0, 20, hit, COLLISION_LAYER_TERRAIN);
+    Check(!isHit, L"SweepBox on terrain hits the goomba");
+    isHit = query.SweepBox(100, -20, 104, -10, 0, 20, hit, COLLISION_LAYER_ALL, &goomba);
+    Check(!isHit, L"SweepBox does not skip the ignored object");
+
+    // without the broadphase, as for a sleeping goomba, only the bricks are left
+    query.SetSources(NULL, &staticLayer, NULL);
+    query.Overlap(0, 0, 200, 16, result);
+    Check(result.size() == 3, L"Overlap finds objects out of the broadphase");
+
+    DebugOut(L"[TEST] Spatial queries: %d checks failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Collision.hpp"
+#include "debug.hpp"
+
+#define BATCH_TEST_MOVERS 2000
+#define BATCH_TEST_TARGETS 1003 // not a multiple of 8, so the kernels run their tails too
+#define BATCH_TEST_SEED 1
+
+/*
+    Every SweptAABBBatch kernel against the scalar CCollision::SweptAABB, on random boxes. The
+    kernels are meant to be bit-exact (see CollisionBatch.cpp), so t, nx and ny are compared bit
+    for bit, no epsilon.
+
+    Coordinates are on a half-pixel lattice and a good share of the movements are 0, so that
+    degenerate pairs come up often: movers or targets that do not move, that move on one axis
+    only, boxes that exactly touch or share an edge
+*/
+
+static float RandomFloat(float a, float b) {
+    return a + (b - a) * (rand() / (float)RAND_MAX);
+}
+
+static float RandomCoordinate() {
+    return (rand() % 129) * 0.5f;
+}
+
+static float RandomMovement() {
+    switch (rand() % 4) {
+    case 0:
+        return 0;
+    case 1:
+        return (rand() % 33 - 16) * 0.5f;
+    default:
+        return RandomFloat(-16, 16);
+    }
+}
+
+static bool IsSameBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+int main() {
+    SetDebugConsole(true);
+    srand(BATCH_TEST_SEED);
+
+    size_t n = BATCH_TEST_TARGETS;
+    vector<float> sl(n), st(n), sr(n), sb(n), sdx(n), sdy(n);
+    vector<float> t(n), nx(n), ny(n);
+
+    const wchar_t *names[] = {L"scalar", L"SSE", L"AVX"};
+    int checked[3] = {0, 0, 0};
+    int mismatches = 0, collisions = 0, touching = 0, still = 0;
+
+    for (int m = 0; m < BATCH_TEST_MOVERS; m++) {
+        float ml = RandomCoordinate(), mt = RandomCoordinate();
+        float mr = ml + 16, mb = mt + 16;
+        float mdx = RandomMovement(), mdy = RandomMovement();
+
+        for (size_t i = 0; i < n; i++) {
+            sl[i] = RandomCoordinate();
+            st[i] = RandomCoordinate();
+            sr[i] = sl[i] + (i % 3 == 0 ? 16 : RandomCoordinate());
+            sb[i] = st[i] + (i % 5 == 0 ? 16 : RandomCoordinate());
+
+            // some targets move with the mover: no relative movement at all
+            bool isStill = rand() % 8 == 0;
+            sdx[i] = isStill ? mdx : (rand() % 2 ? 0 : RandomMovement());
+            sdy[i] = isStill ? mdy : (rand() % 2 ? 0 : RandomMovement());
+
+            // and some exactly touch it
+            if (rand() % 8 == 0)
+                sl[i] = mr;
+            else if (rand() % 8 == 0)
+                sb[i] = mt;
+        }
+
+        for (int kernel = SWEPT_AABB_KERNEL_SCALAR; kernel <= SWEPT_AABB_KERNEL_AVX; kernel++) {
+            if (!CCollision::SweptAABBBatchWith(kernel, ml, mt, mr, mb, mdx, mdy, &sl[0], &st[0], &sr[0], &sb[0],
+                                                &sdx[0], &sdy[0], n, &t[0], &nx[0], &ny[0]))
+                continue;
+            checked[kernel]++;
+
+            for (size_t i = 0; i < n; i++) {
+                float et, enx, eny;
+                float dx = mdx - sdx[i], dy = mdy - sdy[i];
+                CCollision::SweptAABB(ml, mt, mr, mb, dx, dy, sl[i], st[i], sr[i], sb[i], et, enx, eny);
+
+                if (kernel == SWEPT_AABB_KERNEL_SCALAR) {
+                    collisions += et >= 0 && et <= 1;
+                    touching += sl[i] == mr || sb[i] == mt;
+                    still += dx == 0 && dy == 0;
+                }
+
+                if (IsSameBits(t[i], et) && IsSameBits(nx[i], enx) && IsSameBits(ny[i], eny))
+                    continue;
+                if (mismatches++ < 10)
+                    DebugOut(L"[ERROR] %s kernel: mover (%g, %g, %g, %g) by (%g, %g), target (%g, %g, %g, %g) by "
+                             L"(%g, %g): t %g nx %g ny %g, SweptAABB gives t %g nx %g ny %g\n",
+                             names[kernel], ml, mt, mr, mb, mdx, mdy, sl[i], st[i], sr[i], sb[i], sdx[i], sdy[i],
+                             t[i], nx[i], ny[i], et, enx, eny);
+            }
+        }
+    }
+
+    for (int kernel = SWEPT_AABB_KERNEL_SCALAR; kernel <= SWEPT_AABB_KERNEL_AVX; kernel++)
+        DebugOut(L"[TEST] %s kernel: %s\n", names[kernel],
+                 checked[kernel] > 0 ? L"checked" : L"not available on this build or CPU, skipped");
+    DebugOut(L"[TEST] %d pairs per kernel: %d collisions, %d touching, %d without relative movement, %d mismatches\n",
+             BATCH_TEST_MOVERS * BATCH_TEST_TARGETS, collisions, touching, still, mismatches);
+
+    if (checked[SWEPT_AABB_KERNEL_SCALAR] == 0 || collisions == 0 || touching == 0 || still == 0) {
+        DebugOut(L"[ERROR] The random pairs do not cover every case\n");
+        return 1;
+    }
+    return mismatches == 0 ? 0 : 1;
+}